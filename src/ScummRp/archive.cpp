@@ -0,0 +1,277 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2026 Donovan Watteau
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "common/io.hpp"
+#include "common/toolbox.hpp"
+
+#include "archive.hpp"
+
+#include <cstring>
+
+/*
+ * DumpArchive
+ */
+
+const char DumpArchive::MAGIC[4] = { 'S', 'R', 'P', 'A' };
+
+DumpArchive::DumpArchive() :
+    _file(), _writing(false), _entries()
+{
+}
+
+DumpArchive::~DumpArchive()
+{
+	// A destructor shouldn't throw exceptions
+	try
+	{
+		cancel();
+	}
+	catch (std::exception &e)
+	{
+		ScummIO::majorIssue(e.what());
+	}
+}
+
+bool DumpArchive::is_open()
+{
+	return _file.is_open();
+}
+
+void DumpArchive::create(const char *path)
+{
+	cancel();
+	_file.open(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+	if (!_file.is_open())
+		throw File::IOError(xsprintf("Cannot open %s", path));
+
+	_writing = true;
+	_file.write(DumpArchive::MAGIC, sizeof DumpArchive::MAGIC);
+	_file->putLE32(DumpArchive::VERSION);
+}
+
+void DumpArchive::open(const char *path)
+{
+	cancel();
+	_file.open(path, std::ios::binary | std::ios::in);
+	if (!_file.is_open())
+		throw File::IOError(xsprintf("Cannot open %s", path));
+
+	_writing = false;
+	_readIndex();
+}
+
+// Write the index of a new archive, and close it
+void DumpArchive::close()
+{
+	if (!_file.is_open())
+		return;
+
+	if (_writing)
+		_writeIndex();
+
+	cancel();
+}
+
+// Close the archive without writing its index
+void DumpArchive::cancel()
+{
+	if (_file.is_open())
+		_file.close();
+
+	_entries.clear();
+	_writing = false;
+}
+
+// The header takes 8 bytes, the trailer 12, and each index entry at least 10
+void DumpArchive::_readIndex()
+{
+	char magic[sizeof DumpArchive::MAGIC];
+	uint32 version, indexOffset, indexEnd, count, offset, size;
+	uint16 nameLength;
+	std::string name;
+
+	_file.seekg(0, std::ios::beg);
+	_file.read(magic, sizeof magic);
+	_file->getLE32(version);
+	if (std::memcmp(magic, DumpArchive::MAGIC, sizeof magic) != 0 || version != DumpArchive::VERSION)
+		throw DumpArchive::Error(xsprintf("%s is not a ScummRp archive", _file->name().c_str()));
+
+	if (_file.size() < 8 + 12)
+		throw DumpArchive::Error(xsprintf("%s is truncated", _file->name().c_str()));
+
+	indexEnd = (uint32)_file.size() - 12;
+	_file.seekg(-12, std::ios::end);
+	_file->getLE32(indexOffset);
+	_file->getLE32(count);
+	_file.read(magic, sizeof magic);
+	if (std::memcmp(magic, DumpArchive::MAGIC, sizeof magic) != 0 || indexOffset < 8 || indexOffset > indexEnd
+	    || count > (indexEnd - indexOffset) / 10)
+		throw DumpArchive::Error(xsprintf("%s is truncated", _file->name().c_str()));
+
+	_file.seekg(indexOffset, std::ios::beg);
+	for (uint32 i = 0; i < count; ++i)
+	{
+		_file->getLE16(nameLength);
+		_file->read(name, nameLength);
+		_file->getLE32(offset);
+		_file->getLE32(size);
+		if (offset < 8 || offset > indexOffset || size > indexOffset - offset)
+			throw DumpArchive::Error(xsprintf("Bad offset for %s in %s", name.c_str(), _file->name().c_str()));
+
+		_entries[name].offset = (int32)offset;
+		_entries[name].size = (int32)size;
+	}
+}
+
+void DumpArchive::_writeIndex()
+{
+	uint32 indexOffset;
+
+	indexOffset = (uint32)_file.size();
+	_file.seekp(0, std::ios::end);
+	for (std::map<std::string, DumpArchive::Entry>::const_iterator i = _entries.begin(); i != _entries.end(); ++i)
+	{
+		_file->putLE16((uint16)i->first.size());
+		_file.write(i->first);
+		_file->putLE32(i->second.offset);
+		_file->putLE32(i->second.size);
+	}
+	_file->putLE32(indexOffset);
+	_file->putLE32((uint32)_entries.size());
+	_file.write(DumpArchive::MAGIC, sizeof DumpArchive::MAGIC);
+}
+
+bool DumpArchive::contains(const std::string &name) const
+{
+	return _entries.find(name) != _entries.end();
+}
+
+// Blocks are appended to the archive. If a name was already used, the
+// previous block is left unreferenced.
+void DumpArchive::add(const std::string &name, FilePart &data)
+{
+	if (name.size() > 0xFFFF)
+		throw DumpArchive::Error(xsprintf("Name too long: %s", name.c_str()));
+
+	DumpArchive::Entry &entry = _entries[name];
+
+	entry.offset = (int32)_file.size();
+	entry.size = (int32)data.size();
+	data.seekg(0, std::ios::beg);
+	_file.seekp(0, std::ios::end);
+	_file.write(data, data.size());
+}
+
+// The returned part of the archive must be deleted by the caller
+FilePart *DumpArchive::get(const std::string &name)
+{
+	std::map<std::string, DumpArchive::Entry>::const_iterator i = _entries.find(name);
+
+	if (i == _entries.end())
+		return nullptr;
+
+	return new FilePart(*_file, i->second.offset, i->second.size);
+}
+
+/*
+ * DumpQueue
+ */
+
+DumpQueue::DumpQueue() :
+    _pending(), _size(0), _budget(DumpQueue::DEFAULT_BUDGET), _dirs()
+{
+}
+
+DumpQueue::~DumpQueue()
+{
+	// A destructor shouldn't throw exceptions
+	try
+	{
+		flush();
+	}
+	catch (std::exception &e)
+	{
+		ScummIO::majorIssue(e.what());
+	}
+}
+
+void DumpQueue::_makeDir(const std::string &dir)
+{
+	if (dir.empty() || _dirs.find(dir) != _dirs.end())
+		return;
+
+	xmkdir(dir.c_str());
+	_dirs.insert(dir);
+}
+
+void DumpQueue::add(const std::string &dir, const std::string &name, FilePart &data)
+{
+	_pending.push_back(DumpQueue::PendingDump());
+
+	DumpQueue::PendingDump &dump = _pending.back();
+
+	dump.dir = dir;
+	dump.path = dir + name;
+	data.seekg(0, std::ios::beg);
+	data.read(dump.data, data.size());
+	ScummIO::info(INF_LISTING, xsprintf("Exporting %s", dump.path.c_str()));
+
+	_size += dump.data.size();
+	if (_size >= _budget)
+		flush();
+}
+
+void DumpQueue::flush()
+{
+	while (!_pending.empty())
+	{
+		DumpQueue::PendingDump &dump = _pending.front();
+		File output;
+
+		_makeDir(dump.dir);
+		output.open(dump.path.c_str(), std::ios::binary | std::ios::out | std::ios::trunc);
+		if (output.is_open())
+		{
+			output.write(dump.data);
+			output.close();
+		}
+		else
+		{
+			ScummIO::warning(xsprintf("Cannot open %s", dump.path.c_str()));
+		}
+
+		_pending.pop_front();
+	}
+
+	_size = 0;
+}
+
+// Forget the pending dumps, and the directories which were created
+void DumpQueue::clear()
+{
+	_pending.clear();
+	_size = 0;
+	_dirs.clear();
+}
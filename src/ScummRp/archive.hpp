@@ -0,0 +1,145 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2026 Donovan Watteau
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SCUMMRP_ARCHIVE_HPP
+#define SCUMMRP_ARCHIVE_HPP
+
+#include "common/types.hpp"
+#include "common/file.hpp"
+
+#include <list>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+/*
+ * DumpArchive
+ */
+
+// All the dumped blocks in one file, instead of one file per block.
+//
+// "SRPA" LE32:version
+// block data, one after the other
+// index: for each block, LE16:nameLength name LE32:offset LE32:size
+// LE32:indexOffset LE32:numberOfBlocks "SRPA"
+//
+// The index is at the end, so that the archive can be written in one go.
+
+class DumpArchive
+{
+public:
+	static const uint32 VERSION = 1;
+
+public:
+	class Error : public std::runtime_error
+	{
+	public:
+		Error(const std::string &message) : std::runtime_error(message) { }
+	};
+
+protected:
+	struct Entry
+	{
+		int32 offset;
+		int32 size;
+	};
+
+protected:
+	static const char MAGIC[4];
+
+protected:
+	File _file;
+	bool _writing;
+	std::map<std::string, DumpArchive::Entry> _entries;
+
+protected:
+	void _readIndex();
+	void _writeIndex();
+
+public:
+	void create(const char *path);
+	void open(const char *path);
+	void close();
+	void cancel();
+	bool is_open();
+	bool contains(const std::string &name) const;
+	void add(const std::string &name, FilePart &data);
+	FilePart *get(const std::string &name);
+
+public:
+	DumpArchive();
+	~DumpArchive();
+
+private: // Not copiable
+	DumpArchive(const DumpArchive &);
+	DumpArchive &operator=(const DumpArchive &);
+};
+
+/*
+ * DumpQueue
+ */
+
+// Blocks dumped as loose files are kept in memory and written by batches,
+// so that reading the game files and writing the dump don't alternate for
+// every block. Each directory is only created once.
+
+class DumpQueue
+{
+public:
+	static const size_t DEFAULT_BUDGET = 0x800000;
+
+protected:
+	struct PendingDump
+	{
+		std::string dir;
+		std::string path;
+		std::string data;
+	};
+
+protected:
+	std::list<DumpQueue::PendingDump> _pending;
+	size_t _size;
+	size_t _budget;
+	std::set<std::string> _dirs;
+
+protected:
+	void _makeDir(const std::string &dir);
+
+public:
+	void add(const std::string &dir, const std::string &name, FilePart &data);
+	void flush();
+	void clear();
+
+public:
+	DumpQueue();
+	~DumpQueue();
+
+private: // Not copiable
+	DumpQueue(const DumpQueue &);
+	DumpQueue &operator=(const DumpQueue &);
+};
+
+#endif
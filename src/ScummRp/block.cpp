@@ -90,49 +90,44 @@ int Block::getId() const
 	return _id;
 }
 
-const char *Block::tagToStr(uint32 tag)
+std::string Block::tagToStr(uint32 tag)
 {
-	static char strTag[2][5] = { { 0 }, { 0 } };
-	static int currentStr = 0;
+	char strTag[5];
 
-	currentStr ^= 1;
 	if (tag & 0xFFFF0000)
 	{
-		strTag[currentStr][0] = (char)(tag >> 24);
-		strTag[currentStr][1] = (char)((tag >> 16) & 0xFF);
-		strTag[currentStr][2] = (char)((tag >> 8) & 0xFF);
-		strTag[currentStr][3] = (char)(tag & 0xFF);
-		strTag[currentStr][4] = '\0';
+		strTag[0] = (char)(tag >> 24);
+		strTag[1] = (char)((tag >> 16) & 0xFF);
+		strTag[2] = (char)((tag >> 8) & 0xFF);
+		strTag[3] = (char)(tag & 0xFF);
+		strTag[4] = '\0';
 	}
 	else
 	{
-		strTag[currentStr][0] = (char)(tag >> 8);
-		strTag[currentStr][1] = (char)(tag & 0xFF);
-		strTag[currentStr][2] = '\0';
-		if (strTag[currentStr][0] == '\0') // FIXME hack for Loom Talkie
+		strTag[0] = (char)(tag >> 8);
+		strTag[1] = (char)(tag & 0xFF);
+		strTag[2] = '\0';
+		if (strTag[0] == '\0') // FIXME hack for Loom Talkie
 		{
-			strTag[currentStr][0] = '_';
-			strTag[currentStr][1] = '_';
+			strTag[0] = '_';
+			strTag[1] = '_';
 		}
 	}
 
-	return strTag[currentStr];
+	return strTag;
 }
 
-const char *Block::_fileName() const
+std::string Block::_fileName() const
 {
-	static char fileName[32] = { 0 };
-
 	if (_id >= 0)
-		snprintf(fileName, sizeof(fileName), "%s_%.4i", Block::tagToStr(_tag), _id);
-	else
-		snprintf(fileName, sizeof(fileName), "%s", Block::tagToStr(_tag));
+		return xsprintf("%s_%.4i", Block::tagToStr(_tag).c_str(), _id);
 
-	return fileName;
+	return Block::tagToStr(_tag);
 }
 
 void Block::_readHeader(BlockFormat format, FilePart &file, int32 &size, uint32 &tag)
 {
+	uint32 header[2];
 	uint16 w;
 
 	switch (format)
@@ -143,13 +138,14 @@ void Block::_readHeader(BlockFormat format, FilePart &file, int32 &size, uint32
 		tag = (uint32)w;
 		break;
 	case BFMT_LONGTAG:
-		file.getBE32(tag);
-		file.getBE32(size);
+		file.readBE32Array(header, 2);
+		tag = header[0];
+		size = (int32)header[1];
 		break;
 	case BFMT_LONGTAG_ALTSIZE:
-		file.getBE32(tag);
-		file.getBE32(size);
-		size += 8;
+		file.readBE32Array(header, 2);
+		tag = header[0];
+		size = (int32)header[1] + 8;
 		break;
 	case BFMT_SIZEONLY:
 		file.getLE16(w);
@@ -250,7 +246,7 @@ int TreeBlock::_findIdInBlock(TreeBlock &block)
 		{
 			if (subblock._tag == MKTAG4('I','M','H','D'))
 			{
-				if (ScummRp::game.version < 7)
+				if (ScummRp::game().version < 7)
 					subblock._file->seekg(subblock._headerSize, std::ios::beg);
 				else
 					subblock._file->seekg(subblock._headerSize + 4, std::ios::beg);
@@ -265,7 +261,7 @@ int TreeBlock::_findIdInBlock(TreeBlock &block)
 		{
 			if (subblock._tag == MKTAG4('C','D','H','D'))
 			{
-				if (ScummRp::game.version < 7)
+				if (ScummRp::game().version < 7)
 					subblock._file->seekg(subblock._headerSize, std::ios::beg);
 				else
 					subblock._file->seekg(subblock._headerSize + 4, std::ios::beg);
@@ -328,7 +324,7 @@ void TreeBlock::_makeSubblock(TreeBlock &subblock, BlockFormat blockFormat, int3
 
 	if (size < 0 || size + _nextSubblockOffset > _file->size())
 	{
-		if (ScummRp::game.id == GID_MONKEY && _file->fullOffset() == 0x442D4 && size == 0x218B490D && _file->name() == "DISK04.LEC")
+		if (ScummRp::game().id == GID_MONKEY && _file->fullOffset() == 0x442D4 && size == 0x218B490D && _file->name() == "DISK04.LEC")
 			ScummIO::fatal("The MONKEY1-EGA version from Limited Run Games contains a corrupted DISK04.LEC\nSee: https://dwatteau.github.io/scummfixes/corrupted-monkey1-ega-files-limitedrungames.html");
 
 		throw Block::InvalidDataFromGame(xsprintf("Block too big: 0x%X", size), _file->name(), _nextSubblockOffset + _file->fullOffset());
@@ -349,7 +345,7 @@ bool TreeBlock::_readNextSubblock(TreeBlock &subblock)
 	if (_nextSubblockOffset > _file->size())
 		throw Block::InvalidBlock("TreeBlock::_readNextSubblock: Out of bounds");
 
-	_makeSubblock(subblock, ScummRp::game.blockFormat, ScummRp::game.blockHeaderSize);
+	_makeSubblock(subblock, ScummRp::game().blockFormat, ScummRp::game().blockHeaderSize);
 	subblock._id = _findSubblockId(subblock);
 	_nextSubblockOffset += subblock._file->size();
 
@@ -416,6 +412,13 @@ void TreeBlock::_subblockUpdated(TreeBlock &subblock, int32 sizeDiff)
 	if (_parent != nullptr)
 		_parent->_subblockUpdated(*this, sizeDiff);
 
+	_subblockResized(subblock, sizeDiff);
+}
+
+// What _subblockUpdated() does to this block itself, without telling its
+// parent
+void TreeBlock::_subblockResized(TreeBlock &subblock, int32 sizeDiff)
+{
 	if (sizeDiff == 0)
 		return;
 
@@ -455,25 +458,62 @@ void TreeBlock::dump(const char *path)
 	output.close();
 }
 
+void TreeBlock::dump(DumpArchive &archive, const std::string &name)
+{
+	ScummIO::info(INF_LISTING, xsprintf("Exporting %s", name.c_str()));
+	archive.add(name, *_file);
+}
+
+void TreeBlock::dump(DumpQueue &queue, const std::string &dir, const std::string &name)
+{
+	queue.add(dir, name, *_file);
+}
+
 void TreeBlock::update(const char *path)
 {
 	File input;
+
+	input.open(path, std::ios::binary | std::ios::in);
+	if (!input.is_open())
+		return;
+
+	_update(*input, path);
+	input.close();
+}
+
+void TreeBlock::update(DumpArchive &archive, const std::string &name)
+{
+	FilePart *input;
+
+	input = archive.get(name);
+	if (input == nullptr)
+		return;
+
+	try
+	{
+		_update(*input, name.c_str());
+	}
+	catch (...)
+	{
+		delete input;
+		throw;
+	}
+	delete input;
+}
+
+void TreeBlock::_update(FilePart &input, const char *path)
+{
 	int32 newSize, sizeDiff;
 	int id;
 
 	if (_childrenCount > 0)
 		throw std::logic_error("TreeBlock::update: The block has children");
 
-	input.open(path, std::ios::binary | std::ios::in);
-	if (!input.is_open())
-		return;
-
 	newSize = input.size();
 	sizeDiff = newSize - _file->size();
 	if (newSize < _headerSize)
 	{
-		ScummIO::warning(xsprintf("%s not updated: File size < Header size", _fileName()));
-		input.close();
+		ScummIO::warning(xsprintf("%s not updated: File size < Header size", _fileName().c_str()));
 		return;
 	}
 
@@ -493,9 +533,7 @@ void TreeBlock::update(const char *path)
 
 	id = TreeBlock::_findIdInBlock(*this);
 	if (id != _id && id != -1)
-		throw InvalidDataFromDump(xsprintf("%s has the id %i instead of %i", _fileName(), id, _id));
-
-	input.close();
+		throw InvalidDataFromDump(xsprintf("%s has the id %i instead of %i", _fileName().c_str(), id, _id));
 }
 
 /*
@@ -538,13 +576,13 @@ GlobalTocBlock::~GlobalTocBlock()
 void GlobalTocBlock::exportToc(TableOfContent &toc)
 {
 	_file->seekg(_headerSize, std::ios::beg);
-	toc.load(*_file, ScummRp::game.globalTocFormat);
+	toc.load(*_file, ScummRp::game().globalTocFormat);
 }
 
 void GlobalTocBlock::importToc(TableOfContent &toc)
 {
 	_file->seekp(_headerSize, std::ios::beg);
-	toc.save(*_file, ScummRp::game.globalTocFormat);
+	toc.save(*_file, ScummRp::game().globalTocFormat);
 }
 
 /*
@@ -577,20 +615,20 @@ void GlobalTocBlockV1::importToc(TableOfContent &toc)
  */
 
 BlocksFile::BlocksFile() :
-    TreeBlock(), _ownFile(), _ownRAMFile(), _ownSeqFile(), _ownSeqRAMFile()
+    TreeBlock(), _ownFile(), _ownRAMFile(), _ownSeqFile(), _ownSeqRAMFile(), _ownPagedFile(), _ownSeqPagedFile()
 {
 	_blockFormat = BFMT_NOHEADER;
 	_headerSize = 0;
 }
 
 BlocksFile::BlocksFile(const char *path, int opts, BackUp &bak, int id, uint32 tag, byte xorKey) :
-    TreeBlock(), _ownFile(), _ownRAMFile(), _ownSeqFile(), _ownSeqRAMFile()
+    TreeBlock(), _ownFile(), _ownRAMFile(), _ownSeqFile(), _ownSeqRAMFile(), _ownPagedFile(), _ownSeqPagedFile()
 {
 	_openFile(path, opts, &bak, id, tag, xorKey);
 }
 
 BlocksFile::BlocksFile(const char *path, int opts, int id, uint32 tag, byte xorKey) :
-    TreeBlock(), _ownFile(), _ownRAMFile(), _ownSeqFile(), _ownSeqRAMFile()
+    TreeBlock(), _ownFile(), _ownRAMFile(), _ownSeqFile(), _ownSeqRAMFile(), _ownPagedFile(), _ownSeqPagedFile()
 {
 	_openFile(path, opts, nullptr, id, tag, xorKey);
 }
@@ -601,6 +639,9 @@ void BlocksFile::_openFile(const char *path, int opts, BackUp *bak, int id, uint
 	int32 size;
 
 	size = File::fileSize(path);
+	if (opts & BlocksFile::BFOPT_PAGED)
+		opts &= ~(BlocksFile::BFOPT_AUTO | BlocksFile::BFOPT_RAM);
+
 	if (opts & BlocksFile::BFOPT_AUTO)
 	{
 		opts &= ~(BlocksFile::BFOPT_SEQFILE | BlocksFile::BFOPT_RAM);
@@ -615,27 +656,44 @@ void BlocksFile::_openFile(const char *path, int opts, BackUp *bak, int id, uint
 	if (size > 0xA00000 && ((opts & BlocksFile::BFOPT_RAM) || !(opts & BlocksFile::BFOPT_SEQFILE)))
 	{
 		opts |= BlocksFile::BFOPT_SEQFILE;
-		opts &= ~BlocksFile::BFOPT_RAM;
-		ScummIO::info(INF_GLOBAL, "File too big, forced -O and disabled -m");
+		if (opts & BlocksFile::BFOPT_RAM)
+		{
+			opts &= ~BlocksFile::BFOPT_RAM;
+			ScummIO::info(INF_GLOBAL, "File too big, forced -O and disabled -m");
+		}
+		else
+		{
+			ScummIO::info(INF_GLOBAL, "File too big, forced -O");
+		}
 	}
 
 	_blockFormat = BFMT_NOHEADER;
 	_headerSize = 0;
 	_id = id;
 	_tag = tag;
+	if (opts & BlocksFile::BFOPT_PAGED)
+		f = &_ownPagedFile;
+	else if (opts & BlocksFile::BFOPT_RAM)
+		f = &_ownRAMFile;
+	else
+		f = &_ownFile;
+
 	if (opts & BlocksFile::BFOPT_READONLY)
 	{
-		f = (opts & BlocksFile::BFOPT_RAM) ? &_ownRAMFile : &_ownFile;
 		f->open(path, std::ios::binary | std::ios::in);
 	}
 	else
 	{
-		f = (opts & BlocksFile::BFOPT_RAM) ? &_ownRAMFile : &_ownFile;
 		if (bak != nullptr && (opts & BlocksFile::BFOPT_BACKUP))
 		{
 			if (opts & BlocksFile::BFOPT_SEQFILE)
 			{
-				if (opts & BlocksFile::BFOPT_RAM)
+				if (opts & BlocksFile::BFOPT_PAGED)
+				{
+					_ownSeqPagedFile.open(path, *bak);
+					f = &_ownSeqPagedFile;
+				}
+				else if (opts & BlocksFile::BFOPT_RAM)
 				{
 					_ownSeqRAMFile.open(path, *bak);
 					f = &_ownSeqRAMFile;
@@ -660,6 +718,10 @@ void BlocksFile::_openFile(const char *path, int opts, BackUp *bak, int id, uint
 	if (!f->is_open())
 		throw std::runtime_error(xsprintf("Cannot open %s", path));
 
+	// leave some room for the blocks to grow (as translations usually do)
+	if ((opts & BlocksFile::BFOPT_RAM) && !(opts & BlocksFile::BFOPT_READONLY))
+		static_cast<RAMFile *>(f)->reserve(size + size / 8);
+
 	_file = new FilePart(*f);
 	_file->setXORKey(xorKey);
 }
@@ -685,7 +747,7 @@ Room::~Room()
 void Room::_uniqueId(uint32 tag, int32 id)
 {
 	if (std::find(_uIdsSoFar.begin(), _uIdsSoFar.end(), Room::IdAndTag(id, tag)) != _uIdsSoFar.end())
-		throw Room::IdNotUnique(xsprintf("%s #%i is not unique", Block::tagToStr(tag), id));
+		throw Room::IdNotUnique(xsprintf("%s #%i is not unique", Block::tagToStr(tag).c_str(), id));
 
 	_uIdsSoFar.push_back(Room::IdAndTag(id, tag));
 }
@@ -716,16 +778,16 @@ int RoomPack::_findNextLFLFRootBlock(byte roomId, int32 currentOffset, int32 roo
 	toc = nullptr;
 	id = -1;
 	nextOffset = roomSize;
-	for (int i = 0; ScummRp::tocs[i] != nullptr; ++i)
+	for (int i = 0; ScummRp::tocs()[i] != nullptr; ++i)
 	{
-		ScummRp::tocs[i]->firstId(roomId);
-		while (ScummRp::tocs[i]->nextId(blockId, roomId))
+		ScummRp::tocs()[i]->firstId(roomId);
+		while (ScummRp::tocs()[i]->nextId(blockId, roomId))
 		{
-			offset = (int32)(*ScummRp::tocs[i])[blockId].offset;
+			offset = (int32)(*ScummRp::tocs()[i])[blockId].offset;
 			if (offset >= currentOffset && offset < nextOffset)
 			{
 				nextOffset = offset;
-				toc = ScummRp::tocs[i];
+				toc = ScummRp::tocs()[i];
 				id = blockId;
 			}
 		}
@@ -738,12 +800,12 @@ void RoomPack::_moveLFLFRootBlockInToc(byte roomId, int32 minOffset, int32 n) co
 {
 	int blockId;
 
-	for (int i = 0; ScummRp::tocs[i] != nullptr; ++i)
+	for (int i = 0; ScummRp::tocs()[i] != nullptr; ++i)
 	{
-		ScummRp::tocs[i]->firstId(roomId);
-		while (ScummRp::tocs[i]->nextId(blockId, roomId))
-			if ((int32)(*ScummRp::tocs[i])[blockId].offset >= minOffset)
-				(*ScummRp::tocs[i])[blockId].offset += n;
+		ScummRp::tocs()[i]->firstId(roomId);
+		while (ScummRp::tocs()[i]->nextId(blockId, roomId))
+			if ((int32)(*ScummRp::tocs()[i])[blockId].offset >= minOffset)
+				(*ScummRp::tocs()[i])[blockId].offset += n;
 	}
 }
 
@@ -752,65 +814,65 @@ void RoomPack::_checkDupOffset(byte roomId, int32 offset)
 	int n;
 
 	n = 0;
-	for (int i = 0; ScummRp::tocs[i] != nullptr; ++i)
+	for (int i = 0; ScummRp::tocs()[i] != nullptr; ++i)
 	{
-		int j = ScummRp::tocs[i]->count(roomId, offset);
-		if (j == 2 && ScummRp::tocs[i]->getType() == TableOfContent::TOCT_SCRP)
+		int j = ScummRp::tocs()[i]->count(roomId, offset);
+		if (j == 2 && ScummRp::tocs()[i]->getType() == TableOfContent::TOCT_SCRP)
 		{
 			// Hack for Sam & Max CD English
-			if (roomId == 1 && ScummRp::tocs[i]->getSize() == 122
-				&& (*ScummRp::tocs[i])[8].offset == (*ScummRp::tocs[i])[9].offset
-				&& (*ScummRp::tocs[i])[8].roomId == (*ScummRp::tocs[i])[9].roomId)
+			if (roomId == 1 && ScummRp::tocs()[i]->getSize() == 122
+				&& (*ScummRp::tocs()[i])[8].offset == (*ScummRp::tocs()[i])[9].offset
+				&& (*ScummRp::tocs()[i])[8].roomId == (*ScummRp::tocs()[i])[9].roomId)
 			{
-				(*ScummRp::tocs[i])[8].offset = -1;
+				(*ScummRp::tocs()[i])[8].offset = -1;
 				j = 1;
 				ScummIO::info(INF_DETAIL, "Removed SCRP_0008 from index (duplicate of SCRP_0009)");
 			}
 			// Hack for Maniac Mansion V1 (1)
-			else if (roomId == 8 && ScummRp::tocs[i]->getSize() == 200
-				 && (*ScummRp::tocs[i])[7].offset == (*ScummRp::tocs[i])[12].offset
-				 && (*ScummRp::tocs[i])[7].roomId == (*ScummRp::tocs[i])[12].roomId)
+			else if (roomId == 8 && ScummRp::tocs()[i]->getSize() == 200
+				 && (*ScummRp::tocs()[i])[7].offset == (*ScummRp::tocs()[i])[12].offset
+				 && (*ScummRp::tocs()[i])[7].roomId == (*ScummRp::tocs()[i])[12].roomId)
 			{
-				(*ScummRp::tocs[i])[7].offset = -1;
+				(*ScummRp::tocs()[i])[7].offset = -1;
 				j = 1;
 				ScummIO::info(INF_DETAIL, "Removed SC_0007 from index (duplicate of SC_0012)");
 			}
 			// Hack for Maniac Mansion V1 (2)
-			else if (roomId == 8 && ScummRp::tocs[i]->getSize() == 200
-				 && (*ScummRp::tocs[i])[8].offset == (*ScummRp::tocs[i])[13].offset
-				 && (*ScummRp::tocs[i])[8].roomId == (*ScummRp::tocs[i])[13].roomId)
+			else if (roomId == 8 && ScummRp::tocs()[i]->getSize() == 200
+				 && (*ScummRp::tocs()[i])[8].offset == (*ScummRp::tocs()[i])[13].offset
+				 && (*ScummRp::tocs()[i])[8].roomId == (*ScummRp::tocs()[i])[13].roomId)
 			{
-				(*ScummRp::tocs[i])[8].offset = -1;
+				(*ScummRp::tocs()[i])[8].offset = -1;
 				j = 1;
 				ScummIO::info(INF_DETAIL, "Removed SC_0008 from index (duplicate of SC_0013)");
 			}
 			// Hack for Loom EGA English (1)
-			else if (roomId == 11 && ScummRp::tocs[i]->getSize() == 200
-				 && (*ScummRp::tocs[i])[51].offset == (*ScummRp::tocs[i])[52].offset
-				 && (*ScummRp::tocs[i])[51].roomId == (*ScummRp::tocs[i])[52].roomId)
+			else if (roomId == 11 && ScummRp::tocs()[i]->getSize() == 200
+				 && (*ScummRp::tocs()[i])[51].offset == (*ScummRp::tocs()[i])[52].offset
+				 && (*ScummRp::tocs()[i])[51].roomId == (*ScummRp::tocs()[i])[52].roomId)
 			{
-				(*ScummRp::tocs[i])[51].offset = -1;
+				(*ScummRp::tocs()[i])[51].offset = -1;
 				j = 1;
 				ScummIO::info(INF_DETAIL, "Removed SC_0051 from index (duplicate of SC_0052)");
 			}
 			// Hack for Loom EGA English (2).  This one only appears in Loom 1.0 (8 Mar 90)
-			else if (roomId == 18 && ScummRp::tocs[i]->getSize() == 200
-				 && (*ScummRp::tocs[i])[55].offset == (*ScummRp::tocs[i])[56].offset
-				 && (*ScummRp::tocs[i])[55].roomId == (*ScummRp::tocs[i])[56].roomId)
+			else if (roomId == 18 && ScummRp::tocs()[i]->getSize() == 200
+				 && (*ScummRp::tocs()[i])[55].offset == (*ScummRp::tocs()[i])[56].offset
+				 && (*ScummRp::tocs()[i])[55].roomId == (*ScummRp::tocs()[i])[56].roomId)
 			{
-				(*ScummRp::tocs[i])[55].offset = -1;
+				(*ScummRp::tocs()[i])[55].offset = -1;
 				j = 1;
 				ScummIO::info(INF_DETAIL, "Removed SC_0055 from index (duplicate of SC_0056)");
 			}
 		}
-		else if (j == 2 && ScummRp::tocs[i]->getType() == TableOfContent::TOCT_COST)
+		else if (j == 2 && ScummRp::tocs()[i]->getType() == TableOfContent::TOCT_COST)
 		{
 			// Hack for Monkey1 Floppy VGA (some versions only; possibly only 1.0?)
-			if (roomId == 59 && ScummRp::tocs[i]->getSize() == 199
-				&& (*ScummRp::tocs[i])[10].offset == (*ScummRp::tocs[i])[117].offset
-				&& (*ScummRp::tocs[i])[10].roomId == (*ScummRp::tocs[i])[117].roomId)
+			if (roomId == 59 && ScummRp::tocs()[i]->getSize() == 199
+				&& (*ScummRp::tocs()[i])[10].offset == (*ScummRp::tocs()[i])[117].offset
+				&& (*ScummRp::tocs()[i])[10].roomId == (*ScummRp::tocs()[i])[117].roomId)
 			{
-				(*ScummRp::tocs[i])[10].offset = -1;
+				(*ScummRp::tocs()[i])[10].offset = -1;
 				j = 1;
 				ScummIO::info(INF_DETAIL, "Removed CO_0010 from index (duplicate of CO_0117)");
 			}
@@ -825,16 +887,16 @@ void RoomPack::_eraseOffsetsInRange(byte roomId, int32 start, int32 end)
 {
 	int blockId;
 
-	for (int i = 0; ScummRp::tocs[i] != nullptr; ++i)
+	for (int i = 0; ScummRp::tocs()[i] != nullptr; ++i)
 	{
-		ScummRp::tocs[i]->firstId(roomId);
-		while (ScummRp::tocs[i]->nextId(blockId, roomId))
+		ScummRp::tocs()[i]->firstId(roomId);
+		while (ScummRp::tocs()[i]->nextId(blockId, roomId))
 		{
-			TableOfContent::TocElement &el = (*ScummRp::tocs[i])[blockId];
+			TableOfContent::TocElementRef el = (*ScummRp::tocs()[i])[blockId];
 			if (el.offset >= start && el.offset < end)
 			{
 				ScummIO::info(INF_DETAIL, xsprintf("Removed %s #%i (room %.2u, offset 0x%X) from the index",
-				    TableOfContent::typeToStr(ScummRp::tocs[i]->getType()), blockId, el.roomId, el.offset));
+				    TableOfContent::typeToStr(ScummRp::tocs()[i]->getType()), blockId, el.roomId, el.offset));
 				el.offset = -1;
 				el.roomId = (byte)-1;
 			}
@@ -955,22 +1017,28 @@ void LFLFile::_subblockUpdated(TreeBlock &subblock, int32 sizeDiff)
  */
 
 LFLFPack::LFLFPack() :
-    TreeBlock(), RoomPack()
+    TreeBlock(), RoomPack(), _rootBlocks(), _nextRootBlock(0), _tocsOutdated(false),
+    _segment(), _segmentOffset(0), _segmentSize(0), _detached(false), _segmentChanged(false)
 {
 }
 
 LFLFPack::LFLFPack(const TreeBlock &block) :
-    TreeBlock(block)
+    TreeBlock(block), _rootBlocks(), _nextRootBlock(0), _tocsOutdated(false),
+    _segment(), _segmentOffset(0), _segmentSize(0), _detached(false), _segmentChanged(false)
 {
 	_init();
 }
 
 LFLFPack::~LFLFPack()
 {
+	_updateTocs();
+	_dropSegment();
 }
 
 LFLFPack &LFLFPack::operator=(const TreeBlock &block)
 {
+	_updateTocs();
+	_dropSegment();
 	TreeBlock::operator=(block);
 
 	_init();
@@ -984,10 +1052,128 @@ void LFLFPack::_init()
 	// LFLF blocks have a normal 8 bytes header
 	_headerSize = 8;
 
-	for (int i = 0; ScummRp::tocs[i] != nullptr; ++i)
-		ScummRp::tocs[i]->accessing((byte)_id);
+	for (int i = 0; ScummRp::tocs()[i] != nullptr; ++i)
+		ScummRp::tocs()[i]->accessing((byte)_id);
 
 	RoomPack::_eraseOffsetsInRange((byte)_id, _file->size(), 0xFFFFFFFF);
+	_scheduleRootBlocks();
+}
+
+// Sort the blocks of the room by offset once, instead of looking for the
+// next one in all the TOCs every time nextBlock() is called
+void LFLFPack::_scheduleRootBlocks()
+{
+	LFLFPack::RootBlock rootBlock;
+	int blockId;
+	bool dup;
+
+	_rootBlocks.clear();
+	_nextRootBlock = 0;
+	for (int i = 0; ScummRp::tocs()[i] != nullptr; ++i)
+	{
+		ScummRp::tocs()[i]->firstId((byte)_id);
+		while (ScummRp::tocs()[i]->nextId(blockId, (byte)_id))
+		{
+			rootBlock.offset = (int32)(*ScummRp::tocs()[i])[blockId].offset;
+			rootBlock.toc = i;
+			rootBlock.id = blockId;
+			_rootBlocks.push_back(rootBlock);
+		}
+	}
+	std::stable_sort(_rootBlocks.begin(), _rootBlocks.end());
+
+	// known duplicates are removed from the TOCs, other ones are fatal
+	dup = false;
+	for (size_t i = 1; i < _rootBlocks.size(); ++i)
+	{
+		if (_rootBlocks[i].offset == _rootBlocks[i - 1].offset && _rootBlocks[i].offset < (int32)(_file->size() - _headerSize))
+		{
+			RoomPack::_checkDupOffset((byte)_id, _rootBlocks[i].offset);
+			dup = true;
+		}
+	}
+
+	if (dup)
+	{
+		std::vector<LFLFPack::RootBlock>::iterator j = _rootBlocks.begin();
+
+		for (size_t i = 0; i < _rootBlocks.size(); ++i)
+			if ((int32)(*ScummRp::tocs()[_rootBlocks[i].toc])[_rootBlocks[i].id].offset == _rootBlocks[i].offset)
+				*j++ = _rootBlocks[i];
+
+		_rootBlocks.erase(j, _rootBlocks.end());
+	}
+}
+
+// Same as RoomPack::_eraseOffsetsInRange() and _moveLFLFRootBlockInToc(),
+// except that the shifted offsets are only written back to the TOCs by
+// _updateTocs(), once the whole room has been processed
+void LFLFPack::_shiftRootBlocks(int32 start, int32 end, int32 n)
+{
+	std::vector<LFLFPack::RootBlock>::iterator j = _rootBlocks.begin();
+
+	for (size_t i = 0; i < _rootBlocks.size(); ++i)
+	{
+		if (_rootBlocks[i].offset >= start && _rootBlocks[i].offset < end)
+		{
+			TableOfContent &toc = *ScummRp::tocs()[_rootBlocks[i].toc];
+			TableOfContent::TocElementRef el = toc[_rootBlocks[i].id];
+
+			ScummIO::info(INF_DETAIL, xsprintf("Removed %s #%i (room %.2u, offset 0x%X) from the index",
+			    TableOfContent::typeToStr(toc.getType()), _rootBlocks[i].id, el.roomId, _rootBlocks[i].offset));
+			el.offset = -1;
+			el.roomId = (byte)-1;
+			continue;
+		}
+
+		if (_rootBlocks[i].offset >= end)
+		{
+			_rootBlocks[i].offset += n;
+			_tocsOutdated = true;
+		}
+		*j++ = _rootBlocks[i];
+	}
+
+	_rootBlocks.erase(j, _rootBlocks.end());
+}
+
+void LFLFPack::_updateTocs()
+{
+	if (!_tocsOutdated)
+		return;
+
+	for (size_t i = 0; i < _rootBlocks.size(); ++i)
+		(*ScummRp::tocs()[_rootBlocks[i].toc])[_rootBlocks[i].id].offset = _rootBlocks[i].offset;
+
+	_tocsOutdated = false;
+}
+
+int32 LFLFPack::_findNextRootBlock(int32 currentOffset, int32 roomSize, const TableOfContent *&toc, int &id)
+{
+	// the cursor only has to move back if the walk was restarted
+	if (_nextRootBlock > _rootBlocks.size()
+	    || (_nextRootBlock > 0 && _rootBlocks[_nextRootBlock - 1].offset >= currentOffset))
+	{
+		LFLFPack::RootBlock rootBlock;
+
+		rootBlock.offset = currentOffset;
+		_nextRootBlock = std::lower_bound(_rootBlocks.begin(), _rootBlocks.end(), rootBlock) - _rootBlocks.begin();
+	}
+
+	while (_nextRootBlock < _rootBlocks.size() && _rootBlocks[_nextRootBlock].offset < currentOffset)
+		++_nextRootBlock;
+
+	if (_nextRootBlock == _rootBlocks.size() || _rootBlocks[_nextRootBlock].offset >= roomSize)
+	{
+		toc = nullptr;
+		id = -1;
+		return roomSize;
+	}
+
+	toc = ScummRp::tocs()[_rootBlocks[_nextRootBlock].toc];
+	id = _rootBlocks[_nextRootBlock].id;
+
+	return _rootBlocks[_nextRootBlock].offset;
 }
 
 bool LFLFPack::nextBlock(TreeBlock &subblock)
@@ -1001,8 +1187,7 @@ TreeBlock *LFLFPack::nextBlock()
 	int id;
 	TreeBlock *subblock = nullptr;
 
-	_nextSubblockOffset = RoomPack::_findNextLFLFRootBlock((byte)_id, _nextSubblockOffset - _headerSize, _file->size() - _headerSize, toc, id);
-	_checkDupOffset((byte)_id, _nextSubblockOffset);
+	_nextSubblockOffset = _findNextRootBlock(_nextSubblockOffset - _headerSize, _file->size() - _headerSize, toc, id);
 	_nextSubblockOffset += _headerSize;
 	try
 	{
@@ -1030,17 +1215,110 @@ TreeBlock *LFLFPack::nextBlock()
 	return subblock;
 }
 
+// Make the next call to nextBlock() return the block indexed at this offset
+void LFLFPack::seekRootBlock(int32 offset)
+{
+	LFLFPack::RootBlock rootBlock;
+
+	rootBlock.offset = offset;
+	_nextRootBlock = std::lower_bound(_rootBlocks.begin(), _rootBlocks.end(), rootBlock) - _rootBlocks.begin();
+	_nextSubblockOffset = offset + _headerSize;
+}
+
 void LFLFPack::_subblockUpdated(TreeBlock &subblock, int32 sizeDiff)
 {
 	int32 minOffset;
 
-	TreeBlock::_subblockUpdated(subblock, sizeDiff);
+	// a detached room only tells its parent once, when it's reattached
+	if (_detached)
+	{
+		_segmentChanged = true;
+		TreeBlock::_subblockResized(subblock, sizeDiff);
+	}
+	else
+	{
+		TreeBlock::_subblockUpdated(subblock, sizeDiff);
+	}
 	if (sizeDiff == 0)
 		return;
 
 	minOffset = (int32)(subblock._file->offset() + subblock._file->size() - sizeDiff - _headerSize);
-	RoomPack::_eraseOffsetsInRange((byte)_id, subblock._file->offset() + 1 - _headerSize, minOffset);
-	_moveLFLFRootBlockInToc((byte)_id, minOffset, sizeDiff);
+	_shiftRootBlocks((int32)(subblock._file->offset() + 1 - _headerSize), minOffset, sizeDiff);
+}
+
+// Work on a copy of the room in memory, until reattach() is called. Each
+// block imported into the room then only moves the end of the room, instead
+// of the end of the whole file. The offsets of the TOCs are relative to the
+// room, so they don't depend on where the room is.
+void LFLFPack::detach()
+{
+	std::string data;
+
+	if (_detached || _parent == nullptr)
+		return;
+
+	if (_childrenCount > 0)
+		throw std::logic_error("LFLFPack::detach: The block has children");
+
+	_segmentOffset = (int32)_file->offset();
+	_segmentSize = (int32)_file->size();
+	_file->seekg(0, std::ios::beg);
+	_file->read(data, _segmentSize);
+	_segment.openMemory(_file->path().c_str(), data);
+	_file = new FilePart(_segment);
+	_detached = true;
+	_segmentChanged = false;
+}
+
+// Write the room back in place, if it was changed, with a single move of
+// the rest of the file. The parent updates its offsets (e.g. the LOFF block
+// of a LECF pack) from the new size of the room.
+void LFLFPack::reattach()
+{
+	FilePart *part;
+	int32 newSize;
+
+	if (!_detached)
+		return;
+
+	if (_childrenCount > 0)
+		throw std::logic_error("LFLFPack::reattach: The block has children");
+
+	part = new FilePart(*_parent->_file, _segmentOffset, _segmentSize);
+	try
+	{
+		newSize = (int32)_file->size();
+		if (_segmentChanged)
+		{
+			if (newSize < _segmentSize)
+				part->resize(newSize);
+			part->seekp(0, std::ios::beg);
+			_file->seekg(0, std::ios::beg);
+			part->write(*_file, newSize);
+		}
+	}
+	catch (...)
+	{
+		delete part;
+		throw;
+	}
+
+	_file = part;
+	_segment.close();
+	_detached = false;
+	if (_segmentChanged)
+		_parent->_subblockUpdated(*this, newSize - _segmentSize);
+}
+
+// The copy in memory goes away before the file behind it
+void LFLFPack::_dropSegment()
+{
+	if (!_detached)
+		return;
+
+	_file.del();
+	_segment.close();
+	_detached = false;
 }
 
 /*
@@ -1048,22 +1326,26 @@ void LFLFPack::_subblockUpdated(TreeBlock &subblock, int32 sizeDiff)
  */
 
 LECFPack::LECFPack() :
-    TreeBlock(), _firstBlockOffset(0), _loff(), _LOFFOffset(0)
+    TreeBlock(), _firstBlockOffset(0), _loff(), _LOFFOffset(0), _loffOutdated(false), _selectedRooms(nullptr)
 {
 }
 
+// The walks call saveLOFF() once the rooms were processed, so a LOFF can only
+// be outdated here if the walk was interrupted by an exception. That run
+// fails, and its backups drop the changes made to this file.
 LECFPack::~LECFPack()
 {
 }
 
 LECFPack::LECFPack(const TreeBlock &block) :
-    TreeBlock(block), _firstBlockOffset(0), _loff(), _LOFFOffset(0)
+    TreeBlock(block), _firstBlockOffset(0), _loff(), _LOFFOffset(0), _loffOutdated(false), _selectedRooms(nullptr)
 {
 	_init();
 }
 
 LECFPack &LECFPack::operator=(const TreeBlock &block)
 {
+	saveLOFF();
 	TreeBlock::operator=(block);
 
 	_firstBlockOffset = 0;
@@ -1090,22 +1372,89 @@ bool LECFPack::nextBlock(TreeBlock &subblock)
 	nextOffset = _file->size();
 	if (_tag == MKTAG4('L','E','C','F'))
 	{
-		nextOffset += ScummRp::game.blockHeaderSize;
-		_nextSubblockOffset += ScummRp::game.blockHeaderSize;
+		nextOffset += ScummRp::game().blockHeaderSize;
+		_nextSubblockOffset += ScummRp::game().blockHeaderSize;
 	}
 
 	_loff.firstId();
 	while (_loff.nextId(roomId))
-		if ((int32)_loff[roomId] >= _nextSubblockOffset && (int32)_loff[roomId] < nextOffset)
+		if ((int32)_loff[roomId] >= _nextSubblockOffset && (int32)_loff[roomId] < nextOffset && _roomSelected(roomId))
 			nextOffset = _loff[roomId];
 
+	_prefetchRoomAfter(nextOffset);
+
 	if (_tag == MKTAG4('L','E','C','F'))
-		nextOffset -= ScummRp::game.blockHeaderSize;
+		nextOffset -= ScummRp::game().blockHeaderSize;
 	_nextSubblockOffset = nextOffset;
 
 	return TreeBlock::nextBlock(subblock);
 }
 
+// Make the next call to nextBlock() return this room, without reading the
+// ones stored before it
+bool LECFPack::seekRoom(byte roomId)
+{
+	byte r;
+
+	_loff.firstId();
+	while (_loff.nextId(r))
+	{
+		if (r != roomId)
+			continue;
+
+		_nextSubblockOffset = _loff[roomId];
+		if (_tag == MKTAG4('L','E','C','F'))
+			_nextSubblockOffset -= ScummRp::game().blockHeaderSize;
+		return true;
+	}
+
+	return false;
+}
+
+// Only let nextBlock() return these rooms (all of them if null). The other
+// ones are skipped through their LOFF offset, without being read at all.
+void LECFPack::selectRooms(const std::vector<bool> *rooms)
+{
+	_selectedRooms = rooms;
+}
+
+bool LECFPack::_roomSelected(byte roomId) const
+{
+	return _selectedRooms == nullptr || (roomId < _selectedRooms->size() && (*_selectedRooms)[roomId]);
+}
+
+// Let the system read the room after this one while the current one is
+// being processed. Rooms aren't always stored in id order, so use the LOFF
+// offsets to find which one comes next in the file.
+void LECFPack::_prefetchRoomAfter(int32 offset)
+{
+	int32 start, end, headerSize;
+	byte roomId;
+
+	headerSize = (_tag == MKTAG4('L','E','C','F')) ? ScummRp::game().blockHeaderSize : 0;
+	start = end = (int32)_file->size() + headerSize;
+
+	_loff.firstId();
+	while (_loff.nextId(roomId))
+	{
+		if (_loff[roomId] <= offset || !_roomSelected(roomId))
+			continue;
+
+		if (_loff[roomId] < start)
+		{
+			end = start;
+			start = _loff[roomId];
+		}
+		else if (_loff[roomId] > start && _loff[roomId] < end)
+		{
+			end = _loff[roomId];
+		}
+	}
+
+	if (start < end)
+		_file->willNeed(start - headerSize, end - start);
+}
+
 TreeBlock *LECFPack::nextBlock()
 {
 	return TreeBlock::_nextBlock<LFLFPack>();
@@ -1157,8 +1506,18 @@ void LECFPack::_subblockUpdated(TreeBlock &subblock, int32 sizeDiff)
 		if (_loff[roomId] >= minOffset)
 			_loff[roomId] += sizeDiff;
 
+	_loffOutdated = true;
+}
+
+// The LOFF block is only written back once, when all the rooms were processed
+void LECFPack::saveLOFF()
+{
+	if (!_loffOutdated)
+		return;
+
 	_file->seekp(_LOFFOffset, std::ios::beg);
 	_loff.save(*_file);
+	_loffOutdated = false;
 }
 
 /*
@@ -1336,7 +1695,7 @@ bool OldIndexFileV1::nextBlock(TreeBlock &subblock)
 	subblock._id = -1;
 	subblock._nextSubblockOffset = 0;
 
-	switch (ScummRp::game.id)
+	switch (ScummRp::game().id)
 	{
 	case GID_MANIAC:
 		size = MM_SIZES[_pos];
@@ -1424,16 +1783,16 @@ void OldLFLFile::_moveLFLFRootBlockInToc(byte roomId, int32 minOffset, int32 n)
 {
 	int blockId;
 
-	for (int i = 0; ScummRp::tocs[i] != nullptr; ++i)
+	for (int i = 0; ScummRp::tocs()[i] != nullptr; ++i)
 	{
-		ScummRp::tocs[i]->firstId(roomId);
-		while (ScummRp::tocs[i]->nextId(blockId, roomId))
+		ScummRp::tocs()[i]->firstId(roomId);
+		while (ScummRp::tocs()[i]->nextId(blockId, roomId))
 		{
-			if ((int32)(*ScummRp::tocs[i])[blockId].offset >= minOffset)
+			if ((int32)(*ScummRp::tocs()[i])[blockId].offset >= minOffset)
 			{
-				(*ScummRp::tocs[i])[blockId].offset += n;
-				if ((*ScummRp::tocs[i])[blockId].offset >= 0xFFFF)
-					throw RoomPack::BadOffset(xsprintf("Offset too far: 0x%X in %.2i.LFL", (*ScummRp::tocs[i])[blockId].offset, roomId));
+				(*ScummRp::tocs()[i])[blockId].offset += n;
+				if ((*ScummRp::tocs()[i])[blockId].offset >= 0xFFFF)
+					throw RoomPack::BadOffset(xsprintf("Offset too far: 0x%X in %.2i.LFL", (*ScummRp::tocs()[i])[blockId].offset, roomId));
 			}
 		}
 	}
@@ -1935,12 +2294,8 @@ void OldRoom::_getSizes()
 		oiOffsets.resize(objNbr);
 		ocOffsets.resize(objNbr);
 		_file->seekg(_oObjTOC(), std::ios::beg);
-
-		for (i = 0; i < objNbr; ++i)
-			_file->getLE16(oiOffsets[i]);
-
-		for (i = 0; i < objNbr; ++i)
-			_file->getLE16(ocOffsets[i]);
+		_file->readLE16Array(&oiOffsets[0], objNbr);
+		_file->readLE16Array(&ocOffsets[0], objNbr);
 
 		_getOIInfo(bmLastOffset, oiOffsets, ocOffsets);
 		std::sort(oiOffsets.begin(), oiOffsets.end());
@@ -2046,9 +2401,9 @@ void OldRoom::_findMostLikelyOIId(std::vector<int> &candidates) const
 		}
 	}
 
-	msg = xsprintf("%s_%.4i might actually be %s_%.4i", Block::tagToStr(_tags(BT_OI)), _oiId[candidates[0]], Block::tagToStr(_tags(BT_OI)), _oiId[candidates[1]]);
+	msg = xsprintf("%s_%.4i might actually be %s_%.4i", Block::tagToStr(_tags(BT_OI)).c_str(), _oiId[candidates[0]], Block::tagToStr(_tags(BT_OI)).c_str(), _oiId[candidates[1]]);
 	for (i = 2; i < (int)candidates.size(); ++i)
-		msg += xsprintf(" or %s_%.4i", Block::tagToStr(_tags(BT_OI)), _oiId[candidates[i]]);
+		msg += xsprintf(" or %s_%.4i", Block::tagToStr(_tags(BT_OI)).c_str(), _oiId[candidates[i]]);
 
 	if (pref[i].oiNbr != 0)
 	{
@@ -2125,7 +2480,7 @@ void OldRoom::_getOIInfo(uint16 bmLastOffset, std::vector<uint16> &oiOffset, con
 			else
 			{
 				// FIXME Hack for zakv2 which has two bad OI blocks in room 35.
-				if (ScummRp::game.id == GID_ZAK && ScummRp::game.version == 2
+				if (ScummRp::game().id == GID_ZAK && ScummRp::game().version == 2
 					&& oiInfo[k].size == 0x308
 					&& oiInfo[k].num == 11 && _oiId[oiInfo[k].num] == 553
 					&& oiInfo[j].offset - oiInfo[k].offset == 0x384)
@@ -2134,7 +2489,7 @@ void OldRoom::_getOIInfo(uint16 bmLastOffset, std::vector<uint16> &oiOffset, con
 					oiInfo[k].size = 0x384;
 					v.push_back(oiInfo[k].num);
 				}
-				else if (ScummRp::game.id == GID_ZAK && ScummRp::game.version == 2
+				else if (ScummRp::game().id == GID_ZAK && ScummRp::game().version == 2
 					 && oiInfo[k].size == 0x3DE
 					 && oiInfo[k].num == 12 && _oiId[oiInfo[k].num] == 554
 					 && oiInfo[j].offset - oiInfo[k].offset == 0x3C2)
@@ -2147,7 +2502,7 @@ void OldRoom::_getOIInfo(uint16 bmLastOffset, std::vector<uint16> &oiOffset, con
 		}
 
 		if (v.size() == 0)
-			throw Block::InvalidDataFromGame(xsprintf("Bad %s offset", Block::tagToStr(_tags(BT_OI))), _file->name(), _file->fullOffset());
+			throw Block::InvalidDataFromGame(xsprintf("Bad %s offset", Block::tagToStr(_tags(BT_OI)).c_str()), _file->name(), _file->fullOffset());
 
 		if (v.size() > 1)
 			_findMostLikelyOIId(v);
@@ -2187,21 +2542,16 @@ void OldRoom::_defCheckOCSizes(const std::vector<uint16> &ocOffset, int32 ocEnd)
 		_file->getLE16(w);
 
 		if ((int32)(w + ocOffset[i]) != end)
-			throw Block::InvalidDataFromGame(xsprintf("Bad %s offset or size", Block::tagToStr(_tags(BT_OC))), _file->name(), _file->fullOffset());
+			throw Block::InvalidDataFromGame(xsprintf("Bad %s offset or size", Block::tagToStr(_tags(BT_OC)).c_str()), _file->name(), _file->fullOffset());
 	}
 }
 
 void OldRoom::_getBMOffsets(std::vector<uint16> &bmOffset)
 {
-	uint16 w;
-
 	bmOffset.resize(_bmNbr());
 	_file->seekg(_ooBM(), std::ios::beg);
-	for (int i = 0; i < _bmNbr(); ++i)
-	{
-		_file->getLE16(w);
-		bmOffset[i] = w;
-	}
+	if (!bmOffset.empty())
+		_file->readLE16Array(&bmOffset[0], (int)bmOffset.size());
 }
 
 void OldRoom::_calcSizes(std::vector<int32> &sizes, const std::vector<uint16> &offsets, int32 end)
@@ -2241,7 +2591,7 @@ void OldRoom::_updateOffset(int32 offsetToOffset, int32 minOffset, int32 shift,
 	if (offset >= minOffset)
 	{
 		if ((offset + shift) & 0xFFFF0000)
-			throw InvalidDataFromDump(xsprintf("%s block too big", tagToStr(subblockTag)));
+			throw InvalidDataFromDump(xsprintf("%s block too big", tagToStr(subblockTag).c_str()));
 
 		_file->seekp(offsetToOffset, std::ios::beg);
 		_file->putLE16((uint16)(offset + shift));
@@ -2277,7 +2627,7 @@ void OldRoom::_subblockUpdated(TreeBlock &subblock, int32 sizeDiff)
 
 	minOffset = subblock._file->offset() + subblock._file->size() - sizeDiff;
 	if ((subblock._tag & 0xFFFFFF00) == (MKTAG4('H','D','v','#') & 0xFFFFFF00)) // TODO _tagToType(): 'HDv1' -> BT_HD
-		throw InvalidDataFromDump(xsprintf("%s blocks must always be 4 bytes long", tagToStr(subblock._tag)));
+		throw InvalidDataFromDump(xsprintf("%s blocks must always be 4 bytes long", tagToStr(subblock._tag).c_str()));
 
 	if ((oiBlockPtr = dynamic_cast<OldOIBlock *>(&subblock)) != nullptr)
 	{
@@ -2290,7 +2640,7 @@ void OldRoom::_subblockUpdated(TreeBlock &subblock, int32 sizeDiff)
 	else if ((subblock._tag & 0xFFFFFF00) == (MKTAG4('N','L','v','#') & 0xFFFFFF00) || (subblock._tag & 0xFFFFFF00) == (MKTAG4('S','L','v','#') & 0xFFFFFF00))
 	{
 		if (subblock._file->size() & 0xFFFFFF00)
-			throw InvalidDataFromDump(xsprintf("%s blocks must be smaller than 256 bytes", tagToStr(subblock._tag)));
+			throw InvalidDataFromDump(xsprintf("%s blocks must be smaller than 256 bytes", tagToStr(subblock._tag).c_str()));
 
 		if ((subblock._tag & 0xFFFFFF00) == (MKTAG4('S','L','v','#') & 0xFFFFFF00))
 			_file->seekp(_oSLSize(), std::ios::beg);
@@ -2306,7 +2656,7 @@ void OldRoom::_subblockUpdated(TreeBlock &subblock, int32 sizeDiff)
 	{
 		_setBXOffset((uint16)(w + sizeDiff));
 		if (_getBXOffset() < w + sizeDiff)
-			throw InvalidDataFromDump(xsprintf("%s block too big", tagToStr(subblock._tag)));
+			throw InvalidDataFromDump(xsprintf("%s block too big", tagToStr(subblock._tag).c_str()));
 	}
 
 	_updateOffset(_ooEX(), minOffset, sizeDiff, subblock._tag);
@@ -2380,14 +2730,14 @@ void OldRoomV1::_checkOCSizes(const std::vector<uint16> &ocOffset, int32 ocEnd)
 		_file->seekg(ocOffset[i], std::ios::beg);
 		_file->getLE16(w);
 		if (w + ocOffset[i] != ocOffset[i + 1])
-			throw Block::InvalidDataFromGame(xsprintf("Bad %s offset or size", Block::tagToStr(_tags(BT_OC))), _file->name(), _file->fullOffset());
+			throw Block::InvalidDataFromGame(xsprintf("Bad %s offset or size", Block::tagToStr(_tags(BT_OC)).c_str()), _file->name(), _file->fullOffset());
 	}
 
 	// last block
 	_file->seekg(ocOffset.back(), std::ios::beg);
 	_file->getLE16(w);
 	if (w + ocOffset[i] > ocEnd) // <- difference with V2/V3. junk is allowed at the end.
-		throw Block::InvalidDataFromGame(xsprintf("Bad %s offset or size", Block::tagToStr(_tags(BT_OC))), _file->name(), _file->fullOffset());
+		throw Block::InvalidDataFromGame(xsprintf("Bad %s offset or size", Block::tagToStr(_tags(BT_OC)).c_str()), _file->name(), _file->fullOffset());
 }
 
 void OldRoomV1::_setBXOffset(uint16 o)
@@ -30,6 +30,7 @@
 #include "common/file.hpp"
 #include "common/backup.hpp"
 
+#include "archive.hpp"
 #include "toc.hpp"
 #include "rptypes.hpp"
 
@@ -124,10 +125,10 @@ protected:
 	static void _writeHeader(BlockFormat format, FilePart &file, int32 size, uint32 tag);
 
 public:
-	static const char *tagToStr(uint32 tag);
+	static std::string tagToStr(uint32 tag);
 
 protected:
-	const char *_fileName() const;
+	std::string _fileName() const;
 
 public:
 	int32 getHeaderSize() const;
@@ -205,7 +206,9 @@ protected:
 	virtual int _findSubblockId(TreeBlock &subblock) const;
 	virtual bool _readNextSubblock(TreeBlock &subblock);
 	virtual void _subblockUpdated(TreeBlock &subblock, int32 sizeDiff);
+	void _subblockResized(TreeBlock &subblock, int32 sizeDiff);
 	virtual void _adopt(TreeBlock &subblock);
+	void _update(FilePart &input, const char *path);
 	void _makeSubblock(TreeBlock &subblock, BlockFormat blockFormat, int32 headerSize);
 	void _leaveParent();
 	template <class T> T *_nextBlock();
@@ -216,6 +219,9 @@ public:
 	void makePath(std::string &dir, std::string &name) const;
 	void dump(const char *basePath);
 	void update(const char *basePath);
+	void dump(DumpArchive &archive, const std::string &name);
+	void dump(DumpQueue &queue, const std::string &dir, const std::string &name);
+	void update(DumpArchive &archive, const std::string &name);
 
 public:
 	TreeBlock();
@@ -298,16 +304,23 @@ protected:
 	int _firstBlockOffset;
 	RoomIndex _loff;
 	int _LOFFOffset;
+	bool _loffOutdated;
+	const std::vector<bool> *_selectedRooms;
 
 protected:
 	void _init() override;
 	int _findSubblockId(TreeBlock &subblock) const override;
 	void _subblockUpdated(TreeBlock &subblock, int32 sizeDiff) override;
+	void _prefetchRoomAfter(int32 offset);
+	bool _roomSelected(byte roomId) const;
 
 public:
+	void saveLOFF();
 	TreeBlock *nextBlock() override;
 	bool nextBlock(TreeBlock &subblock) override;
 	void firstBlock() override;
+	bool seekRoom(byte roomId);
+	void selectRooms(const std::vector<bool> *rooms);
 
 public:
 	LECFPack();
@@ -374,7 +387,8 @@ public:
 		BFOPT_SEQFILE = 1 << 1,
 		BFOPT_RAM = 1 << 2,
 		BFOPT_READONLY = 1 << 3,
-		BFOPT_BACKUP = 1 << 4
+		BFOPT_BACKUP = 1 << 4,
+		BFOPT_PAGED = 1 << 5
 	};
 
 protected:
@@ -382,6 +396,8 @@ protected:
 	RAMFile _ownRAMFile;
 	SeqFile<File> _ownSeqFile;
 	SeqFile<RAMFile> _ownSeqRAMFile;
+	PagedFile _ownPagedFile;
+	SeqFile<PagedFile> _ownSeqPagedFile;
 
 protected:
 	void _openFile(const char *path, int opts, BackUp *bak, int id, uint32 tag, byte xorKey);
@@ -405,13 +421,41 @@ private: // Not copiable
 
 class LFLFPack : public TreeBlock, public RoomPack
 {
+protected:
+	struct RootBlock
+	{
+		int32 offset;
+		int toc;
+		int id;
+
+		bool operator<(const RootBlock &r) const { return offset < r.offset; }
+	};
+
+protected:
+	std::vector<LFLFPack::RootBlock> _rootBlocks;
+	size_t _nextRootBlock;
+	bool _tocsOutdated;
+	RAMFile _segment;
+	int32 _segmentOffset;
+	int32 _segmentSize;
+	bool _detached;
+	bool _segmentChanged;
+
 protected:
 	void _init() override;
 	void _subblockUpdated(TreeBlock &subblock, int32 sizeDiff) override;
+	void _scheduleRootBlocks();
+	void _shiftRootBlocks(int32 start, int32 end, int32 n);
+	void _updateTocs();
+	int32 _findNextRootBlock(int32 currentOffset, int32 roomSize, const TableOfContent *&toc, int &id);
+	void _dropSegment();
 
 public:
 	TreeBlock *nextBlock() override;
 	bool nextBlock(TreeBlock &subblock) override;
+	void seekRootBlock(int32 offset);
+	void detach();
+	void reattach();
 
 public:
 	LFLFPack();
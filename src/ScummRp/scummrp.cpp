@@ -26,16 +26,32 @@
  */
 
 #include "common/io.hpp"
+#include "common/stats.hpp"
 #include "common/toolbox.hpp"
 
 #include "scummrp.hpp"
 
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <ctime>
 
 #include <algorithm>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <set>
+#include <stdexcept>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(__MSDOS__)
+#  include <sys/types.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
 
 /*
  * ScummRp
@@ -45,22 +61,29 @@ const char *const ScummRp::NAME = "ScummRp";
 const char *const ScummRp::VERSION = "0.6.0";
 const char *const ScummRp::AUTHOR = "Thomas Combeleran";
 
-const GameDefinition &ScummRp::game = ScummRp::_game;
-TableOfContent *const *const &ScummRp::tocs = ScummRp::_tocs;
-
 const ScummRp::Parameter ScummRp::_rpParameters[] =
 {
 	{ 'g', ScummRp::_paramGameId, sizeof ScummRp::_paramGameId, false },
 	{ 'd', ScummRp::_paramDumpingDir, sizeof ScummRp::_paramDumpingDir, true },
+	{ 'a', ScummRp::_paramArchive, sizeof ScummRp::_paramArchive, true },
 	{ 'p', ScummRp::_paramGameDir, sizeof ScummRp::_paramGameDir, true },
 	{ 't', ScummRp::_paramTag, sizeof ScummRp::_paramTag, false },
+	{ 'M', ScummRp::_paramPageBudget, sizeof ScummRp::_paramPageBudget, false },
+	{ 'x', ScummRp::_paramBlock, sizeof ScummRp::_paramBlock, false },
+	{ 'B', ScummRp::_paramBatch, sizeof ScummRp::_paramBatch, true },
+	{ 'j', ScummRp::_paramJobs, sizeof ScummRp::_paramJobs, false },
 	{ '\0', nullptr, 0, false }
 };
 
 char ScummRp::_paramGameId[16] = "";
 char ScummRp::_paramGameDir[512] = ".";
 char ScummRp::_paramDumpingDir[512] = "DUMP";
+char ScummRp::_paramArchive[512] = "";
 char ScummRp::_paramTag[5] = "";
+char ScummRp::_paramPageBudget[8] = "";
+char ScummRp::_paramBlock[16] = "";
+char ScummRp::_paramBatch[512] = "";
+char ScummRp::_paramJobs[8] = "";
 
 // template <int A>
 // void ScummRp::_explore(TreeBlock &tree)
@@ -108,6 +131,50 @@ char ScummRp::_paramTag[5] = "";
 // 			}
 // }
 
+// Only called on import: reading the dumping directory once is much cheaper
+// than probing for every block of the game, most of which were not dumped
+void ScummRp::_scanDumpingDir()
+{
+	std::vector<std::string> files;
+	std::string prefix(ScummRp::_paramDumpingDir);
+	std::string::size_type i;
+
+	ScummRp::_session->dumpFiles.clear();
+	ScummRp::_session->dumpDirs.clear();
+	ScummRp::_session->dumpScanned = true;
+
+	if (!xlistfiles(ScummRp::_paramDumpingDir, files))
+		return;
+
+	if (!prefix.empty() && prefix[prefix.size() - 1] != '/')
+		prefix += '/';
+
+	for (std::vector<std::string>::iterator it = files.begin(); it != files.end(); ++it)
+	{
+		std::string path(prefix + *it);
+
+#if defined(_WIN32) || defined(__MSDOS__)
+		std::transform(path.begin(), path.end(), path.begin(), ::tolower);
+#endif
+		ScummRp::_session->dumpFiles.insert(path);
+		for (i = path.find('/', prefix.size()); i != std::string::npos; i = path.find('/', i + 1))
+			ScummRp::_session->dumpDirs.insert(path.substr(0, i));
+	}
+}
+
+bool ScummRp::_inDumpingDir(std::string path, bool isDir)
+{
+	if (!ScummRp::_session->dumpScanned)
+		ScummRp::_scanDumpingDir();
+
+#if defined(_WIN32) || defined(__MSDOS__)
+	std::transform(path.begin(), path.end(), path.begin(), ::tolower);
+#endif
+	if (isDir)
+		return ScummRp::_session->dumpDirs.find(path) != ScummRp::_session->dumpDirs.end();
+	return ScummRp::_session->dumpFiles.find(path) != ScummRp::_session->dumpFiles.end();
+}
+
 void ScummRp::_explore(TreeBlock &tree, int action)
 {
 	TreeBlockPtr blockPtr;
@@ -115,17 +182,45 @@ void ScummRp::_explore(TreeBlock &tree, int action)
 	std::string path, filename;
 
 	tree.firstBlock();
-	while ((blockPtr = tree.nextBlock()) != nullptr)
+	ScummRp::_seekFilteredBlock(tree);
+	while (!ScummRp::_filterDone() && (blockPtr = tree.nextBlock()) != nullptr)
 	{
-		path = ScummRp::_paramDumpingDir;
+		ScummStats::count(ScummStats::CNT_BLOCKS);
+
+		// blocks are named after their path in the dumping directory, or
+		// from the root of the archive
+		if (ScummRp::_session->dumpArchive.is_open())
+			path.clear();
+		else
+			path = ScummRp::_paramDumpingDir;
 		blockPtr->makePath(path, filename);
 
 		if (blockPtr.is<LFLFPack>() || blockPtr.is<RoomBlock>())
 		{
+			// nothing to import from a room with no dumped blocks
+			if (action == ScummRp::ACT_IMPORT && !ScummRp::_session->dumpArchive.is_open()
+				&& !ScummRp::_inDumpingDir(path + filename, true))
+				continue;
+
 			if (processedBlocks.find(filename) == processedBlocks.end())
+			{
+				ScummStats::Timer timer(ScummStats::PHS_LFLF);
+				LFLFPack *lflf;
+
+				// rooms are rebuilt in memory, and written back in one go
+				lflf = (action == ScummRp::ACT_IMPORT) ? dynamic_cast<LFLFPack *>(&*blockPtr) : nullptr;
+				if (lflf != nullptr)
+					lflf->detach();
 				ScummRp::_explore(*blockPtr, action);
+				if (lflf != nullptr)
+					lflf->reattach();
+			}
 			else
 				ScummIO::warning(xsprintf("%s not unique. Only the first occurence was explored.", filename.c_str()));
+
+			// with -x, the LECF was positioned on the only room to explore
+			if (ScummRp::_session->filterRoom != -1 && blockPtr.is<LFLFPack>())
+				break;
 		}
 		else
 		{
@@ -136,36 +231,56 @@ void ScummRp::_explore(TreeBlock &tree, int action)
 				if (processedBlocks.find(filename) != processedBlocks.end())
 					ScummIO::warning(xsprintf("%s not unique. Only the first occurence was explored.", filename.c_str()));
 
+				if (action == ScummRp::ACT_IMPORT && !ScummRp::_session->dumpArchive.is_open()
+					&& !ScummRp::_inDumpingDir(path + filename, true))
+					break;
+
 				{
-					TreeBlockPtr lecf;
+					LECFPack *lecf;
+					TreeBlockPtr lecfPtr;
 
-					lecf = new LECFPack(*blockPtr);
+					lecfPtr = lecf = new LECFPack(*blockPtr);
 					ScummRp::_explore(*lecf, action);
+					lecf->saveLOFF();
 				}
 				break;
 			default:
-				if (ScummRp::_filterTag && blockPtr->getTag() != ScummRp::_filterTag)
+				if (ScummRp::_session->filterTag && blockPtr->getTag() != ScummRp::_session->filterTag)
+					break;
+				if (ScummRp::_session->filterId != -1 && blockPtr->getId() != ScummRp::_session->filterId)
 					break;
+				ScummRp::_session->filterFound = true;
 
 				if (processedBlocks.find(filename) != processedBlocks.end())
 					ScummIO::warning(xsprintf("%s not unique. Only the first occurence was %s.", filename.c_str(), action == ScummRp::ACT_IMPORT ? "replaced" : "dumped"));
 
-				if (action == ScummRp::ACT_IMPORT)
+				if (action == ScummRp::ACT_IMPORT && ScummRp::_session->dumpArchive.is_open())
+				{
+					path += filename;
+					if (ScummRp::_session->dumpArchive.contains(path))
+					{
+						blockPtr->update(ScummRp::_session->dumpArchive, path);
+						processedBlocks.insert(filename);
+					}
+				}
+				else if (action == ScummRp::ACT_IMPORT)
 				{
 					path += filename;
-					if (File::exists(path.c_str()))
+					if (ScummRp::_inDumpingDir(path, false))
 					{
 						blockPtr->update(path.c_str());
 						processedBlocks.insert(filename);
 					}
 				}
-				else if (action == ScummRp::ACT_EXPORT)
+				else if (action == ScummRp::ACT_EXPORT && ScummRp::_session->dumpArchive.is_open())
 				{
-					if (path.size() > 0)
-						xmkdir(path.c_str());
-
 					path += filename;
-					blockPtr->dump(path.c_str());
+					blockPtr->dump(ScummRp::_session->dumpArchive, path);
+					processedBlocks.insert(filename);
+				}
+				else if (action == ScummRp::ACT_EXPORT)
+				{
+					blockPtr->dump(ScummRp::_session->dumpQueue, path, filename);
 					processedBlocks.insert(filename);
 				}
 			}
@@ -180,6 +295,7 @@ void ScummRp::_explore(TreeBlock &tree, int action)
 template <int A>
 void ScummRp::_exploreIndex(TreeBlock &index)
 {
+	ScummStats::Timer timer(A == ScummRp::ACT_SAVE ? ScummStats::PHS_INDEX_SAVE : ScummStats::PHS_INDEX_LOAD);
 	GlobalTocBlockPtr tocBlockPtr;
 
 	index.firstBlock();
@@ -193,9 +309,9 @@ void ScummRp::_exploreIndex(TreeBlock &index)
 		case MKTAG4('0','R','v','2'):
 		case MKTAG4('0','R','v','3'):
 			if (A == ScummRp::ACT_SAVE)
-				tocBlockPtr->importToc(ScummRp::_mainTocSet.roomToc);
+				tocBlockPtr->importToc(ScummRp::_session->mainTocSet.roomToc);
 			else if (A == ScummRp::ACT_LOAD)
-				tocBlockPtr->exportToc(ScummRp::_mainTocSet.roomToc);
+				tocBlockPtr->exportToc(ScummRp::_session->mainTocSet.roomToc);
 			break;
 		case MKTAG4('D','S','C','R'):
 		case MKTAG2('0','S'):
@@ -203,9 +319,9 @@ void ScummRp::_exploreIndex(TreeBlock &index)
 		case MKTAG4('0','S','v','2'):
 		case MKTAG4('0','S','v','3'):
 			if (A == ScummRp::ACT_SAVE)
-				tocBlockPtr->importToc(ScummRp::_mainTocSet.scrpToc);
+				tocBlockPtr->importToc(ScummRp::_session->mainTocSet.scrpToc);
 			else if (A == ScummRp::ACT_LOAD)
-				tocBlockPtr->exportToc(ScummRp::_mainTocSet.scrpToc);
+				tocBlockPtr->exportToc(ScummRp::_session->mainTocSet.scrpToc);
 			break;
 		case MKTAG4('D','S','O','U'):
 		case MKTAG2('0','N'):
@@ -213,9 +329,9 @@ void ScummRp::_exploreIndex(TreeBlock &index)
 		case MKTAG4('0','N','v','2'):
 		case MKTAG4('0','N','v','3'):
 			if (A == ScummRp::ACT_SAVE)
-				tocBlockPtr->importToc(ScummRp::_mainTocSet.sounToc);
+				tocBlockPtr->importToc(ScummRp::_session->mainTocSet.sounToc);
 			else if (A == ScummRp::ACT_LOAD)
-				tocBlockPtr->exportToc(ScummRp::_mainTocSet.sounToc);
+				tocBlockPtr->exportToc(ScummRp::_session->mainTocSet.sounToc);
 			break;
 		case MKTAG4('D','C','O','S'):
 		case MKTAG2('0','C'):
@@ -223,15 +339,15 @@ void ScummRp::_exploreIndex(TreeBlock &index)
 		case MKTAG4('0','C','v','2'):
 		case MKTAG4('0','C','v','3'):
 			if (A == ScummRp::ACT_SAVE)
-				tocBlockPtr->importToc(ScummRp::_mainTocSet.costToc);
+				tocBlockPtr->importToc(ScummRp::_session->mainTocSet.costToc);
 			else if (A == ScummRp::ACT_LOAD)
-				tocBlockPtr->exportToc(ScummRp::_mainTocSet.costToc);
+				tocBlockPtr->exportToc(ScummRp::_session->mainTocSet.costToc);
 			break;
 		case MKTAG4('D','C','H','R'):
 			if (A == ScummRp::ACT_SAVE)
-				tocBlockPtr->importToc(ScummRp::_mainTocSet.charToc);
+				tocBlockPtr->importToc(ScummRp::_session->mainTocSet.charToc);
 			else if (A == ScummRp::ACT_LOAD)
-				tocBlockPtr->exportToc(ScummRp::_mainTocSet.charToc);
+				tocBlockPtr->exportToc(ScummRp::_session->mainTocSet.charToc);
 			break;
 		default:
 			break;
@@ -253,53 +369,53 @@ int ScummRp::_findGameDef(const char *shortName)
 
 TreeBlock *ScummRp::_newIndex(const char *path)
 {
-	if (ScummRp::_game.version <= 1)
-		return new OldIndexFileV1(path, ScummRp::_fileOptions, ScummRp::_backupSystem, -1, ScummRp::_game.indexXorKey);
-	else if (ScummRp::_game.version <= 2)
-		return new OldIndexFileV2(path, ScummRp::_fileOptions, ScummRp::_backupSystem, -1, ScummRp::_game.indexXorKey);
-	else if (ScummRp::_game.version <= 3 && ScummRp::_game.blockFormat == BFMT_SIZEONLY)
-		return new OldIndexFileV3(path, ScummRp::_fileOptions, ScummRp::_backupSystem, -1, ScummRp::_game.indexXorKey);
+	if (ScummRp::_session->game.version <= 1)
+		return new OldIndexFileV1(path, ScummRp::_session->fileOptions, ScummRp::_session->backupSystem, -1, ScummRp::_session->game.indexXorKey);
+	else if (ScummRp::_session->game.version <= 2)
+		return new OldIndexFileV2(path, ScummRp::_session->fileOptions, ScummRp::_session->backupSystem, -1, ScummRp::_session->game.indexXorKey);
+	else if (ScummRp::_session->game.version <= 3 && ScummRp::_session->game.blockFormat == BFMT_SIZEONLY)
+		return new OldIndexFileV3(path, ScummRp::_session->fileOptions, ScummRp::_session->backupSystem, -1, ScummRp::_session->game.indexXorKey);
 	else
-		return new IndexFile(path, ScummRp::_fileOptions, ScummRp::_backupSystem, -1, ScummRp::_game.indexXorKey);
+		return new IndexFile(path, ScummRp::_session->fileOptions, ScummRp::_session->backupSystem, -1, ScummRp::_session->game.indexXorKey);
 }
 
 LFLFile *ScummRp::_newLFL(const char *path, int id)
 {
-	if (ScummRp::_game.version <= 1)
-		return new OldLFLFileV1(path, ScummRp::_fileOptions, ScummRp::_backupSystem, id, ScummRp::_game.dataXorKey);
-	else if (ScummRp::_game.version <= 2)
-		return new OldLFLFileV2(path, ScummRp::_fileOptions, ScummRp::_backupSystem, id, ScummRp::_game.dataXorKey);
-	else if (ScummRp::_game.version <= 3 && ScummRp::_game.blockFormat == BFMT_SIZEONLY)
-		return new OldLFLFileV3(path, ScummRp::_fileOptions, ScummRp::_backupSystem, id, ScummRp::_game.dataXorKey);
+	if (ScummRp::_session->game.version <= 1)
+		return new OldLFLFileV1(path, ScummRp::_session->fileOptions, ScummRp::_session->backupSystem, id, ScummRp::_session->game.dataXorKey);
+	else if (ScummRp::_session->game.version <= 2)
+		return new OldLFLFileV2(path, ScummRp::_session->fileOptions, ScummRp::_session->backupSystem, id, ScummRp::_session->game.dataXorKey);
+	else if (ScummRp::_session->game.version <= 3 && ScummRp::_session->game.blockFormat == BFMT_SIZEONLY)
+		return new OldLFLFileV3(path, ScummRp::_session->fileOptions, ScummRp::_session->backupSystem, id, ScummRp::_session->game.dataXorKey);
 	else
-		return new LFLFile(path, ScummRp::_fileOptions, ScummRp::_backupSystem, id, ScummRp::_game.dataXorKey);
+		return new LFLFile(path, ScummRp::_session->fileOptions, ScummRp::_session->backupSystem, id, ScummRp::_session->game.dataXorKey);
 }
 
 void ScummRp::_prepareTmpIndex()
 {
-	for (int i = 0; ScummRp::_mainTocs[i] != nullptr; ++i)
+	for (int i = 0; ScummRp::_session->mainTocs[i] != nullptr; ++i)
 	{
-		*ScummRp::_updTocs[i] = *ScummRp::_mainTocs[i];
-		*ScummRp::_tmpTocs[i] = *ScummRp::_mainTocs[i];
+		*ScummRp::_session->updTocs[i] = *ScummRp::_session->mainTocs[i];
+		*ScummRp::_session->tmpTocs[i] = *ScummRp::_session->mainTocs[i];
 	}
-	ScummRp::_tocs = ScummRp::_tmpTocs;
+	ScummRp::_session->tocs = ScummRp::_session->tmpTocs;
 }
 
 void ScummRp::_mergeTmpIndex()
 {
-	for (int i = 0; ScummRp::_mainTocs[i] != nullptr; ++i)
+	for (int i = 0; ScummRp::_session->mainTocs[i] != nullptr; ++i)
 	{
-		ScummRp::_updTocs[i]->merge(*ScummRp::_tmpTocs[i]);
-		*ScummRp::_tmpTocs[i] = *ScummRp::_mainTocs[i];
+		ScummRp::_session->updTocs[i]->merge(*ScummRp::_session->tmpTocs[i]);
+		*ScummRp::_session->tmpTocs[i] = *ScummRp::_session->mainTocs[i];
 	}
 }
 
 void ScummRp::_updateMainIndex()
 {
-	for (int i = 0; ScummRp::_mainTocs[i] != nullptr; ++i)
-		ScummRp::_mainTocs[i]->merge(*ScummRp::_updTocs[i]);
+	for (int i = 0; ScummRp::_session->mainTocs[i] != nullptr; ++i)
+		ScummRp::_session->mainTocs[i]->merge(*ScummRp::_session->updTocs[i]);
 
-	ScummRp::_tocs = ScummRp::_mainTocs;
+	ScummRp::_session->tocs = ScummRp::_session->mainTocs;
 }
 
 #ifdef SCUMMTR_HAS_GOOD_GCC_DIAGNOSTIC_PRAGMA_FEATURES
@@ -315,31 +431,37 @@ void ScummRp::_processGameFilesV123()
 	TreeBlockPtr index;
 
 	indexPath += '/';
-	indexPath += ScummRp::_game.indexFileName;
+	indexPath += ScummRp::_session->game.indexFileName;
 
 	index = ScummRp::_newIndex(indexPath.c_str());
 	ScummRp::_exploreIndex<ScummRp::ACT_LOAD>(*index);
+	ScummRp::_locateFilteredBlock();
 
 	for (int i = 1; i < 98; ++i)
 	{
 		std::string dataPath(ScummRp::_paramGameDir);
-		TreeBlockPtr room;
 
-		snprintf(dataFileName, sizeof(dataFileName), ScummRp::_game.dataFileName, i); // ignore -Wformat-security here, ScummRp::_game.dataFileName is internal and safe
+		if (ScummRp::_session->filterRoom != -1 && i != ScummRp::_session->filterRoom)
+			continue;
+
+		snprintf(dataFileName, sizeof(dataFileName), ScummRp::_session->game.dataFileName, i); // ignore -Wformat-security here, ScummRp::_session->game.dataFileName is internal and safe
 		dataPath += '/';
 		dataPath += dataFileName;
 
-		if (File::exists(dataPath.c_str()))
-		{
-			room = ScummRp::_newLFL(dataPath.c_str(), i);
-			if (ScummRp::_options & ScummRp::OPT_IMPORT)
-				ScummRp::_explore(*room, ScummRp::ACT_IMPORT);
-			else
-				ScummRp::_explore(*room, ScummRp::ACT_EXPORT);
-		}
+		if (!File::exists(dataPath.c_str()))
+			continue;
+
+		ScummStats::Timer timer(ScummStats::PHS_DISK);
+		TreeBlockPtr room;
+
+		room = ScummRp::_newLFL(dataPath.c_str(), i);
+		if (ScummRp::_session->options & ScummRp::OPT_IMPORT)
+			ScummRp::_explore(*room, ScummRp::ACT_IMPORT);
+		else
+			ScummRp::_explore(*room, ScummRp::ACT_EXPORT);
 	}
 
-	if (ScummRp::_options & ScummRp::OPT_IMPORT)
+	if (ScummRp::_session->options & ScummRp::OPT_IMPORT)
 	{
 		ScummIO::setQuiet(true);
 		ScummRp::_exploreIndex<ScummRp::ACT_SAVE>(*index);
@@ -355,23 +477,30 @@ void ScummRp::_processGameFilesV4567()
 	int numberOfDisks;
 
 	indexPath += '/';
-	indexPath += ScummRp::_game.indexFileName;
+	indexPath += ScummRp::_session->game.indexFileName;
 
 	index = ScummRp::_newIndex(indexPath.c_str());
 	ScummRp::_exploreIndex<ScummRp::ACT_LOAD>(*index);
 
-	numberOfDisks = ScummRp::_mainTocSet.roomToc.numberOfDisks();
+	ScummRp::_locateFilteredBlock();
+
+	numberOfDisks = ScummRp::_session->mainTocSet.roomToc.numberOfDisks();
 	ScummRp::_prepareTmpIndex();
 	for (int i = 1; i < numberOfDisks; ++i)
 	{
 		std::string dataPath(ScummRp::_paramGameDir);
+
+		if (ScummRp::_session->filterRoom != -1 && i != ScummRp::_session->mainTocSet.roomToc[ScummRp::_session->filterRoom].roomId)
+			continue;
+
+		ScummStats::Timer timer(ScummStats::PHS_DISK);
 		TreeBlockPtr disk;
 
-		snprintf(dataFileName, sizeof(dataFileName), ScummRp::_game.dataFileName, i); // ignore -Wformat-security here, ScummRp::_game.dataFileName is internal and safe
+		snprintf(dataFileName, sizeof(dataFileName), ScummRp::_session->game.dataFileName, i); // ignore -Wformat-security here, ScummRp::_session->game.dataFileName is internal and safe
 		dataPath += '/';
 		dataPath += dataFileName;
-		disk = new BlocksFile(dataPath.c_str(), ScummRp::_fileOptions, ScummRp::_backupSystem, i, MKTAG4('D','I','S','K'), ScummRp::_game.dataXorKey);
-		if (ScummRp::_options & ScummRp::OPT_IMPORT)
+		disk = new BlocksFile(dataPath.c_str(), ScummRp::_session->fileOptions, ScummRp::_session->backupSystem, i, MKTAG4('D','I','S','K'), ScummRp::_session->game.dataXorKey);
+		if (ScummRp::_session->options & ScummRp::OPT_IMPORT)
 			ScummRp::_explore(*disk, ScummRp::ACT_IMPORT);
 		else
 			ScummRp::_explore(*disk, ScummRp::ACT_EXPORT);
@@ -380,7 +509,7 @@ void ScummRp::_processGameFilesV4567()
 
 	ScummRp::_updateMainIndex();
 
-	if (ScummRp::_options & ScummRp::OPT_IMPORT)
+	if (ScummRp::_session->options & ScummRp::OPT_IMPORT)
 	{
 		ScummIO::setQuiet(true);
 		ScummRp::_exploreIndex<ScummRp::ACT_SAVE>(*index);
@@ -396,11 +525,14 @@ int ScummRp::main(int argc, const char **argv)
 	int g;
 
 	ScummRp::_getOptions(argc, argv, ScummRp::_rpParameters);
-	ScummIO::setInfoSlots(ScummRp::_infoSlots);
+	ScummIO::setInfoSlots(ScummRp::_session->infoSlots);
 	ScummIO::info(INF_GLOBAL, xsprintf("%s %s (build %s) by %s", ScummRp::NAME, ScummRp::VERSION, SCUMMTR_BUILD_DATE, ScummRp::AUTHOR));
 	ScummIO::info(INF_GLOBAL, "");
 
-	if (ScummRp::_options & ScummRp::OPT_LIST)
+	if (ScummRp::_session->options & ScummRp::OPT_BATCH)
+		return ScummRp::_batch(ScummRp::NAME, ScummRp::run, ScummRp::_rpParameters);
+
+	if (ScummRp::_session->options & ScummRp::OPT_LIST)
 	{
 		ScummRp::_listGames();
 		return 0;
@@ -419,41 +551,389 @@ int ScummRp::main(int argc, const char **argv)
 		return 0;
 	}
 
-	ScummRp::_filterTag = 0;
+	ScummRp::_session->filterTag = 0;
 	for (int i = 0; ScummRp::_paramTag[i] != '\0'; ++i)
-		ScummRp::_filterTag = (ScummRp::_filterTag << 8) | ScummRp::_paramTag[i];
+		ScummRp::_session->filterTag = (ScummRp::_session->filterTag << 8) | ScummRp::_paramTag[i];
 
-	ScummRp::_game = ScummRp::_gameDef[g];
+	ScummRp::_session->game = ScummRp::_gameDef[g];
+	ScummRp::_setPageBudget();
+	ScummRp::_setBlockFilter();
 
 #ifndef SCUMMRP_OK_TO_CORRUPT_MANIACV2
-	if (ScummRp::_game.version == 2 && ScummRp::_game.id == GID_MANIAC && ScummRp::_options & ScummRp::OPT_IMPORT)
+	if (ScummRp::_session->game.version == 2 && ScummRp::_session->game.id == GID_MANIAC && ScummRp::_session->options & ScummRp::OPT_IMPORT)
 		ScummIO::fatal("Sorry, modifying Maniac Mansion V2 currently corrupts it (bug #16)");
 #endif
 
 	// FIXME: <https://github.com/dwatteau/scummtr/issues/47>
-	if (ScummRp::_game.version == 4 && ScummRp::_game.id == GID_MONKEY && ScummRp::_options & ScummRp::OPT_IMPORT)
+	if (ScummRp::_session->game.version == 4 && ScummRp::_session->game.id == GID_MONKEY && ScummRp::_session->options & ScummRp::OPT_IMPORT)
 		ScummIO::warning("ScummVM may incorrectly display the floppy versions of Monkey1 when modifying them\nTest them with DREAMM/DOSBox instead, or add a ScummVM MD5 detection entry for them (bug #47)");
 
-	if (ScummRp::_options & ScummRp::OPT_IMPORT)
-		ScummRp::_fileOptions |= BlocksFile::BFOPT_BACKUP;
+	if (ScummRp::_session->options & ScummRp::OPT_IMPORT)
+		ScummRp::_session->fileOptions |= BlocksFile::BFOPT_BACKUP;
 	else
-		ScummRp::_fileOptions |= BlocksFile::BFOPT_READONLY;
+		ScummRp::_session->fileOptions |= BlocksFile::BFOPT_READONLY;
 
-	if (ScummRp::_game.version <= 4)
-		ScummRp::_fileOptions &= ~BlocksFile::BFOPT_SEQFILE;
-	if (ScummRp::_game.version >= 7)
-		ScummRp::_fileOptions |= BlocksFile::BFOPT_SEQFILE;
+	if (ScummRp::_session->game.version <= 4)
+		ScummRp::_session->fileOptions &= ~BlocksFile::BFOPT_SEQFILE;
+	if (ScummRp::_session->game.version >= 7)
+		ScummRp::_session->fileOptions |= BlocksFile::BFOPT_SEQFILE;
 
-	if (ScummRp::_game.version < 4)
+	if (ScummRp::_paramArchive[0] != '\0')
+	{
+		if (ScummRp::_session->options & ScummRp::OPT_IMPORT)
+			ScummRp::_session->dumpArchive.open(ScummRp::_paramArchive);
+		else
+			ScummRp::_session->dumpArchive.create(ScummRp::_paramArchive);
+	}
+
+	if (ScummRp::_session->game.version < 4)
 		ScummRp::_processGameFilesV123();
 	else
 		ScummRp::_processGameFilesV4567();
 
-	ScummRp::_backupSystem.applyChanges();
+	ScummRp::_session->dumpArchive.close();
+	ScummRp::_session->dumpQueue.flush();
+
+	if (ScummRp::_session->filterId != -1 && !ScummRp::_session->filterFound)
+		ScummIO::warning(xsprintf("Block %s was not found", ScummRp::_paramBlock));
+
+	ScummRp::_session->backupSystem.applyChanges();
+	ScummStats::report(ScummRp::NAME);
 
 	return 0;
 }
 
+// Put the process-wide state back as it is when the program starts (the
+// tables and backups of a run are in its own Session)
+void ScummRp::_reset()
+{
+	ScummStats::reset();
+
+	std::strcpy(ScummRp::_paramGameId, "");
+	std::strcpy(ScummRp::_paramGameDir, ".");
+	std::strcpy(ScummRp::_paramDumpingDir, "DUMP");
+	std::strcpy(ScummRp::_paramArchive, "");
+	std::strcpy(ScummRp::_paramTag, "");
+	std::strcpy(ScummRp::_paramPageBudget, "");
+	std::strcpy(ScummRp::_paramBlock, "");
+	std::strcpy(ScummRp::_paramBatch, "");
+	std::strcpy(ScummRp::_paramJobs, "");
+	PagedFile::setBudget(PagedFile::DEFAULT_BUDGET);
+}
+
+// Runs mainFunc() on a new Session, which is dropped once done. If anything
+// goes wrong, the game files are left untouched and nothing is dumped.
+// Not reentrant: the state outside the Session is shared by all runs.
+int ScummRp::_run(int (*mainFunc)(int, const char **), void (*resetFunc)(), int argc, const char **argv)
+{
+	ScummRp::Session session, *previous;
+	bool throwOnFatal;
+	int r;
+
+	previous = ScummRp::_session;
+	ScummRp::_session = &session;
+	throwOnFatal = ScummIO::setThrowOnFatal(true);
+	try
+	{
+		resetFunc();
+		r = mainFunc(argc, argv);
+	}
+	catch (...)
+	{
+		session.backupSystem.cancelChanges();
+		session.dumpArchive.cancel();
+		session.dumpQueue.clear();
+		ScummRp::_session = previous;
+		ScummIO::setThrowOnFatal(throwOnFatal);
+		throw;
+	}
+	ScummRp::_session = previous;
+	ScummIO::setThrowOnFatal(throwOnFatal);
+
+	return r;
+}
+
+// Same as main(), but meant to be called from another program: it can be
+// called several times, errors are thrown instead of exiting, and the game
+// files are left untouched if anything goes wrong. This is only a
+// command-line style entry point: the options are given as in argv, and
+// there is no finer API to open, walk, export or import a game.
+int ScummRp::run(int argc, const char **argv)
+{
+	return ScummRp::_run(ScummRp::main, ScummRp::_reset, argc, argv);
+}
+
+// Arguments are separated by blanks, and may be quoted with "" if they
+// contain some
+void ScummRp::_splitArgs(const std::string &line, std::vector<std::string> &args)
+{
+	std::string arg;
+	bool quoted, inArg;
+
+	args.clear();
+	quoted = inArg = false;
+	for (size_t i = 0; i < line.size(); ++i)
+	{
+		if (line[i] == '"')
+		{
+			quoted = !quoted;
+			inArg = true;
+		}
+		else if (!quoted && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r'))
+		{
+			if (inArg)
+				args.push_back(arg);
+			arg.clear();
+			inArg = false;
+		}
+		else
+		{
+			arg += line[i];
+			inArg = true;
+		}
+	}
+
+	if (inArg)
+		args.push_back(arg);
+}
+
+// The -p value of a job, found the same way as _getOptions() does
+std::string ScummRp::_gameDirArg(const std::vector<std::string> &args, const ScummRp::Parameter *params)
+{
+	for (size_t i = 0; i < args.size(); ++i)
+	{
+		const std::string &arg = args[i];
+		std::string pending;
+
+		if (arg.compare(0, 7, "--stats") == 0)
+			continue;
+		if (arg.compare(0, 2, "--") == 0)
+			break;
+		if (arg.empty() || arg[0] != '-')
+			continue;
+
+		for (size_t j = 1; j < arg.size(); ++j)
+			for (int k = 0; params[k].c != '\0'; ++k)
+				if (params[k].c == arg[j] && pending.find(arg[j]) == std::string::npos)
+					pending += arg[j];
+
+		for (size_t j = 0; j < pending.size() && i + 1 < args.size(); ++j)
+			if (pending[j] == 'p')
+				return args[++i];
+			else
+				++i;
+	}
+
+	return ".";
+}
+
+int ScummRp::_maxJobs()
+{
+	long n;
+
+	if (ScummRp::_paramJobs[0] != '\0')
+	{
+		n = std::strtol(ScummRp::_paramJobs, nullptr, 10);
+		if (n <= 0)
+			ScummIO::fatal("-j value must be a positive number of jobs");
+		return (int)n;
+	}
+
+#if !defined(_WIN32) && !defined(__MSDOS__) && defined(_SC_NPROCESSORS_ONLN)
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n > 0)
+		return (int)n;
+#endif
+
+	return 1;
+}
+
+// Runs a single job of a batch in this process, with its output going to
+// <name>.log
+int ScummRp::_runJob(const std::string &name, const std::vector<std::string> &args, const char *toolName, int (*runFunc)(int, const char **), std::string &result)
+{
+	std::vector<const char *> argv;
+	std::ofstream log;
+	std::streambuf *out, *err;
+	int infoSlots, r;
+
+	log.open((name + ".log").c_str(), std::ios::out | std::ios::trunc);
+	if (!log.is_open())
+	{
+		result = xsprintf("FAILED (cannot create %s.log)", name.c_str());
+		return ScummRp::JOB_NO_LOG;
+	}
+
+	argv.assign(1, toolName);
+	for (size_t i = 0; i < args.size(); ++i)
+		argv.push_back(args[i].c_str());
+
+	infoSlots = ScummRp::_session->infoSlots;
+	out = std::cout.rdbuf(log.rdbuf());
+	err = std::cerr.rdbuf(log.rdbuf());
+	try
+	{
+		if (runFunc((int)argv.size(), &argv[0]) != 0)
+			throw std::runtime_error("Unsuccessful exit status");
+		result = "OK";
+		r = ScummRp::JOB_OK;
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		result = std::string("FAILED (") + e.what() + ")";
+		r = ScummRp::JOB_FAILED;
+	}
+	std::cout.rdbuf(out);
+	std::cerr.rdbuf(err);
+	ScummIO::setInfoSlots(infoSlots);
+
+	return r;
+}
+
+// Run all the jobs of a manifest, one per line: a job name, and the usual
+// arguments of this tool. The output of each job goes to <name>.log, and a
+// summary is printed once all jobs are done. Failed jobs don't stop the
+// batch (their game files are left untouched).
+//
+// Where fork() is available, up to -j jobs are run at once, each by its own
+// worker process, but never two jobs with the same -p game directory.
+// Elsewhere, the jobs are run one after another in this process.
+int ScummRp::_batch(const char *toolName, int (*runFunc)(int, const char **), const ScummRp::Parameter *params)
+{
+	static bool batching = false;
+	std::ifstream manifest;
+	std::string line;
+	std::vector<std::string> args, names, results;
+	std::vector<std::vector<std::string> > jobArgs;
+	std::vector<std::time_t> starts;
+	std::vector<double> durations;
+	int maxJobs, failures;
+
+	if (batching)
+		throw std::runtime_error("Cannot run a batch from a batch");
+
+	maxJobs = ScummRp::_maxJobs();
+	manifest.open(ScummRp::_paramBatch);
+	if (!manifest.is_open())
+		ScummIO::fatal(xsprintf("Cannot open %s", ScummRp::_paramBatch));
+
+	while (std::getline(manifest, line))
+	{
+		ScummRp::_splitArgs(line, args);
+		if (args.empty() || args[0][0] == '#')
+			continue;
+
+		names.push_back(args[0]);
+		jobArgs.push_back(std::vector<std::string>(args.begin() + 1, args.end()));
+	}
+	results.assign(names.size(), "FAILED (not run)");
+	starts.assign(names.size(), 0);
+	durations.assign(names.size(), 0.0);
+
+	batching = true;
+#if !defined(_WIN32) && !defined(__MSDOS__)
+	{
+		std::map<pid_t, size_t> running;
+		std::map<pid_t, size_t>::iterator it;
+		std::set<std::string> busyDirs;
+		std::vector<std::string> dirs;
+		std::vector<bool> started(names.size(), false);
+		size_t done, i;
+		pid_t pid;
+		int status;
+
+		for (i = 0; i < names.size(); ++i)
+			dirs.push_back(ScummRp::_gameDirArg(jobArgs[i], params));
+
+		done = 0;
+		while (done < names.size())
+		{
+			for (i = 0; i < names.size() && (int)running.size() < maxJobs; ++i)
+			{
+				if (started[i] || busyDirs.count(dirs[i]) != 0)
+					continue;
+
+				started[i] = true;
+				ScummIO::info(INF_GLOBAL, xsprintf("Running %s...", names[i].c_str()));
+				starts[i] = std::time(nullptr);
+				std::cout.flush();
+				std::cerr.flush();
+				pid = fork();
+				if (pid == 0)
+				{
+					// The worker only reports its outcome through its exit
+					// status, the details are in its log
+					status = ScummRp::_runJob(names[i], jobArgs[i], toolName, runFunc, results[i]);
+					std::cout.flush();
+					std::cerr.flush();
+					_exit(status);
+				}
+				if (pid == -1)
+				{
+					ScummRp::_runJob(names[i], jobArgs[i], toolName, runFunc, results[i]);
+					durations[i] = std::difftime(std::time(nullptr), starts[i]);
+					++done;
+					continue;
+				}
+				running[pid] = i;
+				busyDirs.insert(dirs[i]);
+			}
+
+			if (running.empty())
+				continue;
+
+			pid = waitpid(-1, &status, 0);
+			if (pid == -1)
+			{
+				if (errno == EINTR)
+					continue;
+				break;
+			}
+			if ((it = running.find(pid)) == running.end())
+				continue;
+
+			i = it->second;
+			running.erase(it);
+			busyDirs.erase(dirs[i]);
+			++done;
+			durations[i] = std::difftime(std::time(nullptr), starts[i]);
+			if (WIFEXITED(status) && WEXITSTATUS(status) == ScummRp::JOB_OK)
+				results[i] = "OK";
+			else if (WIFEXITED(status) && WEXITSTATUS(status) == ScummRp::JOB_NO_LOG)
+				results[i] = xsprintf("FAILED (cannot create %s.log)", names[i].c_str());
+			else if (WIFSIGNALED(status))
+				results[i] = xsprintf("FAILED (killed by signal %i)", WTERMSIG(status));
+			else
+				results[i] = xsprintf("FAILED (see %s.log)", names[i].c_str());
+		}
+	}
+#else
+	(void)maxJobs;
+	(void)params;
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		ScummIO::info(INF_GLOBAL, xsprintf("Running %s...", names[i].c_str()));
+		starts[i] = std::time(nullptr);
+		ScummRp::_runJob(names[i], jobArgs[i], toolName, runFunc, results[i]);
+		durations[i] = std::difftime(std::time(nullptr), starts[i]);
+	}
+#endif
+	batching = false;
+
+	failures = 0;
+	ScummIO::info(INF_GLOBAL, "");
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		if (results[i] != "OK")
+			++failures;
+		ScummIO::info(INF_GLOBAL, xsprintf("%s: %s in %.0fs", names[i].c_str(), results[i].c_str(), durations[i]));
+	}
+	ScummIO::info(INF_GLOBAL, xsprintf("%i job(s), %i failed", (int)names.size(), failures));
+
+	return failures == 0 ? 0 : 1;
+}
+
 void ScummRp::_queueParam(char *pendingParams, char c)
 {
 	int j;
@@ -469,11 +949,30 @@ void ScummRp::_queueParam(char *pendingParams, char c)
 	pendingParams[j + 1] = '\0';
 }
 
+// The only long option, shared by both tools: --stats or --stats=json
+bool ScummRp::_readStatsOption(const char *arg)
+{
+	if (std::strncmp(arg, "--stats", 7) != 0)
+		return false;
+
+	if (arg[7] == '\0')
+		ScummStats::enable(ScummStats::FMT_TEXT);
+	else if (std::strcmp(arg + 7, "=json") == 0)
+		ScummStats::enable(ScummStats::FMT_JSON);
+	else
+		ScummIO::fatal(xsprintf("Unrecognized \"%s\" option", arg));
+
+	return true;
+}
+
 bool ScummRp::_readOption(const char *arg, char *pendingParams)
 {
 	int i;
 	char c;
 
+	if (ScummRp::_readStatsOption(arg))
+		return true;
+
 	i = 0;
 	if (arg[i++] == '-')
 	{
@@ -484,41 +983,52 @@ bool ScummRp::_readOption(const char *arg, char *pendingParams)
 			case '-':
 				return false;
 			case 'o':
-				ScummRp::_options |= ScummRp::OPT_EXPORT;
+				ScummRp::_session->options |= ScummRp::OPT_EXPORT;
 				break;
 			case 'i':
-				ScummRp::_options |= ScummRp::OPT_IMPORT;
+				ScummRp::_session->options |= ScummRp::OPT_IMPORT;
 				break;
 			case 'L':
-				ScummRp::_options |= ScummRp::OPT_LIST;
+				ScummRp::_session->options |= ScummRp::OPT_LIST;
 				return false;
+			case 'B':
+				ScummRp::_session->options |= ScummRp::OPT_BATCH;
+				ScummRp::_queueParam(pendingParams, c);
+				break;
 			case 's':
-				ScummRp::_fileOptions = BlocksFile::BFOPT_NULL;
+				ScummRp::_session->fileOptions = BlocksFile::BFOPT_NULL;
 				break;
 			case 'O':
-				ScummRp::_fileOptions &= ~BlocksFile::BFOPT_AUTO;
-				ScummRp::_fileOptions |= BlocksFile::BFOPT_SEQFILE;
+				ScummRp::_session->fileOptions &= ~BlocksFile::BFOPT_AUTO;
+				ScummRp::_session->fileOptions |= BlocksFile::BFOPT_SEQFILE;
 				break;
 			case 'm':
-				ScummRp::_fileOptions &= ~BlocksFile::BFOPT_AUTO;
-				ScummRp::_fileOptions |= BlocksFile::BFOPT_RAM;
+				ScummRp::_session->fileOptions &= ~BlocksFile::BFOPT_AUTO;
+				ScummRp::_session->fileOptions |= BlocksFile::BFOPT_RAM;
+				break;
+			case 'M':
+				ScummRp::_session->fileOptions |= BlocksFile::BFOPT_PAGED;
+				ScummRp::_queueParam(pendingParams, c);
 				break;
 			case 'q':
-				ScummRp::_infoSlots = INF_NULL;
+				ScummRp::_session->infoSlots = INF_NULL;
 				break;
 			case 'v':
-				ScummRp::_infoSlots |= INF_DETAIL;
+				ScummRp::_session->infoSlots |= INF_DETAIL;
 				break;
 			case 'V':
-				ScummRp::_infoSlots |= INF_LISTING;
+				ScummRp::_session->infoSlots |= INF_LISTING;
 				break;
 			case 'g':
-				ScummRp::_options |= ScummRp::OPT_GAME_FILES;
+				ScummRp::_session->options |= ScummRp::OPT_GAME_FILES;
 				ScummRp::_queueParam(pendingParams, c);
 				break;
 			case 't':
+			case 'x':
+			case 'a':
 			case 'd':
 			case 'p':
+			case 'j':
 				ScummRp::_queueParam(pendingParams, c);
 				break;
 			default:
@@ -536,24 +1046,148 @@ void ScummRp::_usage()
 	std::cout << "options:\n\n";
 	std::cout << " -i         " << "import blocks into the game files (input)\n";
 	std::cout << " -o         " << "export blocks from the game files (output)\n";
-	std::cout << " -L         " << "list supported games\n\n";
+	std::cout << " -L         " << "list supported games\n";
+	std::cout << " -B path    " << "run all the scummrp jobs listed in this manifest file\n\n";
+	std::cout << " -a path    " << "use a single archive file instead of the dumping directory\n";
 	std::cout << " -d path    " << "path to dumping directory (default: " << ScummRp::_paramDumpingDir << ")\n";
 	std::cout << " -g gameid  " << "select a game (as given by -L)\n";
+	std::cout << " -j jobs    " << "with -B, run at most this many jobs at once (default: one per CPU)\n";
 // 	std::cout << " -m         " << "work in memory (whole game files are loaded in RAM)\n";
+	std::cout << " -M size    " << "work in memory, with at most this many MB per game file\n";
 // 	std::cout << " -O         " << "optimize for sequential access (with -i)\n";
 	std::cout << " -p path    " << "path to the game (default: current directory)\n";
 	std::cout << " -q         " << "quiet mode\n";
 // 	std::cout << " -s         " << "slow mode (disable automatic -m or -O)\n";
 	std::cout << " -t tag     " << "only export/import blocks with this tag\n";
 	std::cout << " -v         " << "verbose mode\n";
-	std::cout << " -V         " << "more verbose mode (lists blocks)\n\n";
+	std::cout << " -V         " << "more verbose mode (lists blocks)\n";
+	std::cout << " -x tag:id  " << "only export/import this block (SCRP, SOUN, COST or CHAR)\n";
+	std::cout << " --stats    " << "print timings and counters once done (--stats=json for JSON)\n\n";
 	std::cout << "Examples:\n";
 	std::cout << "scummrp -g monkey2 -p MI2 -od MI2_DUMP\n";
-	std::cout << "scummrp -g loomcd -t SCRP -o\n\n";
+	std::cout << "scummrp -g loomcd -t SCRP -o\n";
+	std::cout << "scummrp -g monkey2 -x SCRP:34 -o\n\n";
 
 	printCommonDisclaimer();
 }
 
+void ScummRp::_setPageBudget()
+{
+	long mb;
+
+	if (!(ScummRp::_session->fileOptions & BlocksFile::BFOPT_PAGED))
+		return;
+
+	mb = std::strtol(ScummRp::_paramPageBudget, nullptr, 10);
+	if (mb <= 0)
+		ScummIO::fatal("-M value must be a positive number of megabytes");
+
+	PagedFile::setBudget((std::streamsize)mb << 20);
+}
+
+void ScummRp::_setBlockFilter()
+{
+	const char *sep;
+	char *end;
+	long id;
+
+	if (ScummRp::_paramBlock[0] == '\0')
+		return;
+
+	if (ScummRp::_paramTag[0] != '\0')
+		ScummIO::fatal("-t and -x cannot be used together");
+
+	sep = std::strchr(ScummRp::_paramBlock, ':');
+	if (sep == nullptr || sep == ScummRp::_paramBlock || sep - ScummRp::_paramBlock > 4)
+		ScummIO::fatal("-x value must look like tag:id (e.g. SCRP:34)");
+
+	id = std::strtol(sep + 1, &end, 10);
+	if (end == sep + 1 || *end != '\0' || id < 0 || id > 0xFFFF)
+		ScummIO::fatal("-x value must look like tag:id (e.g. SCRP:34)");
+
+	ScummRp::_session->filterTag = 0;
+	for (const char *p = ScummRp::_paramBlock; p != sep; ++p)
+		ScummRp::_session->filterTag = (ScummRp::_session->filterTag << 8) | (byte)*p;
+	ScummRp::_session->filterId = (int)id;
+}
+
+// Find where the block given with -x is stored, so that only its room has
+// to be opened, and the walk can go straight to it
+void ScummRp::_locateFilteredBlock()
+{
+	TableOfContent *toc;
+	TableOfContent::TocElement el;
+
+	if (ScummRp::_session->filterId == -1)
+		return;
+
+	switch (ScummRp::_session->filterTag)
+	{
+	case MKTAG4('S','C','R','P'):
+	case MKTAG2('S','C'):
+	case MKTAG4('S','C','v','1'):
+	case MKTAG4('S','C','v','2'):
+	case MKTAG4('S','C','v','3'):
+		toc = &ScummRp::_session->mainTocSet.scrpToc;
+		break;
+	case MKTAG4('S','O','U','N'):
+	case MKTAG2('S','O'):
+	case MKTAG4('S','O','v','1'):
+	case MKTAG4('S','O','v','2'):
+	case MKTAG4('S','O','v','3'):
+		toc = &ScummRp::_session->mainTocSet.sounToc;
+		break;
+	case MKTAG4('C','O','S','T'):
+	case MKTAG2('C','O'):
+	case MKTAG4('C','O','v','1'):
+	case MKTAG4('C','O','v','2'):
+	case MKTAG4('C','O','v','3'):
+		toc = &ScummRp::_session->mainTocSet.costToc;
+		break;
+	case MKTAG4('C','H','A','R'):
+		toc = &ScummRp::_session->mainTocSet.charToc;
+		break;
+	default:
+		ScummIO::fatal("-x only works with blocks listed in the index (SCRP, SOUN, COST or CHAR)");
+		return;
+	}
+
+	if (ScummRp::_session->filterId >= toc->getSize())
+		ScummIO::fatal(xsprintf("Block %s is not in the index", ScummRp::_paramBlock));
+
+	el = (*toc)[ScummRp::_session->filterId];
+	if (el.offset <= 0 || el.roomId == (byte)-1 || el.roomId >= ScummRp::_session->mainTocSet.roomToc.getSize())
+		ScummIO::fatal(xsprintf("Block %s is not in the index", ScummRp::_paramBlock));
+
+	ScummRp::_session->filterRoom = el.roomId;
+	ScummRp::_session->filterOffset = el.offset;
+	ScummIO::info(INF_DETAIL, xsprintf("%s is in room %i, at offset 0x%X", ScummRp::_paramBlock, ScummRp::_session->filterRoom, ScummRp::_session->filterOffset));
+}
+
+void ScummRp::_seekFilteredBlock(TreeBlock &tree)
+{
+	LECFPack *lecf;
+	LFLFPack *lflf;
+
+	if (ScummRp::_session->filterRoom == -1)
+		return;
+
+	if ((lecf = dynamic_cast<LECFPack *>(&tree)) != nullptr)
+	{
+		if (!lecf->seekRoom((byte)ScummRp::_session->filterRoom))
+			ScummIO::fatal(xsprintf("Room %i is not in the LOFF block", ScummRp::_session->filterRoom));
+	}
+	else if ((lflf = dynamic_cast<LFLFPack *>(&tree)) != nullptr)
+	{
+		lflf->seekRootBlock(ScummRp::_session->filterOffset);
+	}
+}
+
+bool ScummRp::_filterDone()
+{
+	return ScummRp::_session->filterRoom != -1 && ScummRp::_session->filterFound;
+}
+
 void ScummRp::_getOptions(int argc, const char **argv, const ScummRp::Parameter *params)
 {
 	char pendingParams[MAX_PARAMS + 1];
@@ -593,11 +1227,11 @@ bool ScummRp::_invalidOptions()
 	static const uint32 mandatory[] = { ScummRp::OPT_IMPORT | ScummRp::OPT_EXPORT, ScummRp::OPT_GAME_FILES, 0 };
 
 	for (int i = 0; mandatory[i] != 0; ++i)
-		if (!(ScummRp::_options & mandatory[i]))
+		if (!(ScummRp::_session->options & mandatory[i]))
 			return true;
 
 	for (int i = 0; exclusive[i] != 0; ++i)
-		if ((ScummRp::_options & exclusive[i]) == exclusive[i])
+		if ((ScummRp::_session->options & exclusive[i]) == exclusive[i])
 			return true;
 
 	return false;
@@ -690,37 +1324,31 @@ const GameDefinition ScummRp::_gameDef[] =
  *
  */
 
-GameDefinition ScummRp::_game = { nullptr, nullptr, nullptr, nullptr, GID_NULL, 0, 0, 0, GTCFMT_NULL, BFMT_NULL, 0, GF_NULL };
-
-int ScummRp::_fileOptions = BlocksFile::BFOPT_AUTO;
-int ScummRp::_options = ScummRp::OPT_NULL;
-BackUp ScummRp::_backupSystem;
-int ScummRp::_infoSlots = INF_GLOBAL;
-TableOfContent *const *ScummRp::_tocs = ScummRp::_mainTocs;
-uint32 ScummRp::_filterTag = 0;
+ScummRp::Session ScummRp::_mainSession;
+ScummRp::Session *ScummRp::_session = &ScummRp::_mainSession;
 
-ScummRp::TOCSet ScummRp::_mainTocSet;
-ScummRp::TOCSet ScummRp::_tmpTocSet;
-ScummRp::TOCSet ScummRp::_updTocSet;
+/*
+ * ScummRp::Session
+ */
 
-TableOfContent *const ScummRp::_mainTocs[] =
+void ScummRp::Session::_setTocs(TableOfContent **tocs, ScummRp::TOCSet &tocSet)
 {
-	&ScummRp::_mainTocSet.roomToc, &ScummRp::_mainTocSet.scrpToc,
-	&ScummRp::_mainTocSet.sounToc, &ScummRp::_mainTocSet.costToc,
-	&ScummRp::_mainTocSet.charToc,
-	nullptr
-};
-TableOfContent *const ScummRp::_tmpTocs[] =
-{
-	&ScummRp::_tmpTocSet.roomToc, &ScummRp::_tmpTocSet.scrpToc,
-	&ScummRp::_tmpTocSet.sounToc, &ScummRp::_tmpTocSet.costToc,
-	&ScummRp::_tmpTocSet.charToc,
-	nullptr
-};
-TableOfContent *const ScummRp::_updTocs[] =
+	tocs[0] = &tocSet.roomToc;
+	tocs[1] = &tocSet.scrpToc;
+	tocs[2] = &tocSet.sounToc;
+	tocs[3] = &tocSet.costToc;
+	tocs[4] = &tocSet.charToc;
+	tocs[5] = nullptr;
+}
+
+ScummRp::Session::Session() :
+    game(), mainTocSet(), tmpTocSet(), updTocSet(), tocs(nullptr),
+    fileOptions(BlocksFile::BFOPT_AUTO), options(ScummRp::OPT_NULL), infoSlots(INF_GLOBAL),
+    backupSystem(), dumpArchive(), dumpQueue(), dumpFiles(), dumpDirs(), dumpScanned(false),
+    filterTag(0), filterId(-1), filterRoom(-1), filterOffset(-1), filterFound(false)
 {
-	&ScummRp::_updTocSet.roomToc, &ScummRp::_updTocSet.scrpToc,
-	&ScummRp::_updTocSet.sounToc, &ScummRp::_updTocSet.costToc,
-	&ScummRp::_updTocSet.charToc,
-	nullptr
-};
+	ScummRp::Session::_setTocs(mainTocs, mainTocSet);
+	ScummRp::Session::_setTocs(tmpTocs, tmpTocSet);
+	ScummRp::Session::_setTocs(updTocs, updTocSet);
+	tocs = mainTocs;
+}
@@ -29,10 +29,15 @@
 #include "common/types.hpp"
 #include "common/backup.hpp"
 
+#include "archive.hpp"
 #include "block.hpp"
 #include "toc.hpp"
 #include "rptypes.hpp"
 
+#include <set>
+#include <string>
+#include <vector>
+
 // TODO make it instanciable (though it's not needed yet)
 
 class ScummRp
@@ -55,7 +60,9 @@ protected:
 		OPT_GAME_FILES = 1 << 4,
 		OPT_RAMFILES = 1 << 5,
 		OPT_TAG = 1 << 6,
-		OPT_INVALID = 1 << 7
+		OPT_INVALID = 1 << 7,
+		OPT_SERVE = 1 << 8,
+		OPT_BATCH = 1 << 9
 	};
 	struct TOCSet
 	{
@@ -76,6 +83,47 @@ protected:
 		{
 		}
 	};
+	// What a run works on. main() uses a single static one, but run() gives
+	// each call its own, so that no tables or backups are left over from a
+	// previous job. ScummIO, ScummStats, the paged file budget and the
+	// ScummTr options are still process-wide: they are only reset between
+	// runs, so there must be one run at a time.
+	struct Session
+	{
+	public:
+		GameDefinition game;
+		ScummRp::TOCSet mainTocSet;
+		ScummRp::TOCSet tmpTocSet;
+		ScummRp::TOCSet updTocSet;
+		TableOfContent *mainTocs[6];
+		TableOfContent *tmpTocs[6];
+		TableOfContent *updTocs[6];
+		TableOfContent *const *tocs;
+		int fileOptions;
+		int options;
+		int infoSlots;
+		BackUp backupSystem;
+		DumpArchive dumpArchive;
+		DumpQueue dumpQueue;
+		std::set<std::string> dumpFiles;
+		std::set<std::string> dumpDirs;
+		bool dumpScanned;
+		uint32 filterTag;
+		int filterId;
+		int filterRoom;
+		int32 filterOffset;
+		bool filterFound;
+
+	private:
+		static void _setTocs(TableOfContent **tocs, ScummRp::TOCSet &tocSet);
+
+	public:
+		Session();
+
+	private: // Not copiable
+		Session(const Session &);
+		Session &operator=(const Session &);
+	};
 	enum
 	{
 		ACT_NULL = 0,
@@ -84,6 +132,12 @@ protected:
 		ACT_SAVE,
 		ACT_LOAD
 	};
+	enum
+	{
+		JOB_OK = 0,
+		JOB_FAILED = 1,
+		JOB_NO_LOG = 2
+	};
 
 protected:
 	static const GameDefinition _gameDef[];
@@ -98,34 +152,43 @@ protected:
 	static const ScummRp::Parameter _rpParameters[];
 
 protected:
-	static GameDefinition _game;
-	static ScummRp::TOCSet _mainTocSet;
-	static ScummRp::TOCSet _tmpTocSet;
-	static ScummRp::TOCSet _updTocSet;
-	static TableOfContent *const _mainTocs[];
-	static TableOfContent *const _tmpTocs[];
-	static TableOfContent *const _updTocs[];
-	static int _fileOptions;
-	static int _options;
-	static BackUp _backupSystem;
-	static int _infoSlots;
-	static TableOfContent *const *_tocs;
+	static ScummRp::Session _mainSession;
+	static ScummRp::Session *_session;
 	static char _paramGameId[16];
 	static char _paramGameDir[512];
 	static char _paramDumpingDir[512];
+	static char _paramArchive[512];
 	static char _paramTag[5];
-	static uint32 _filterTag;
+	static char _paramPageBudget[8];
+	static char _paramBlock[16];
+	static char _paramBatch[512];
+	static char _paramJobs[8];
 
 public:
-	static const GameDefinition &game;
-	static TableOfContent *const *const &tocs;
+	static const GameDefinition &game() { return ScummRp::_session->game; }
+	static TableOfContent *const *tocs() { return ScummRp::_session->tocs; }
 
 protected:
 	static void _queueParam(char *pendingParams, char c);
+	static bool _readStatsOption(const char *arg);
 	static bool _readOption(const char *arg, char *pendingParams);
 	static void _getOptions(int argc, const char **argv, const ScummRp::Parameter *params);
 	static bool _invalidOptions();
 	static void _usage();
+	static void _setPageBudget();
+	static void _setBlockFilter();
+	static void _locateFilteredBlock();
+	static void _seekFilteredBlock(TreeBlock &tree);
+	static bool _filterDone();
+	static void _reset();
+	static int _run(int (*mainFunc)(int, const char **), void (*resetFunc)(), int argc, const char **argv);
+	static void _splitArgs(const std::string &line, std::vector<std::string> &args);
+	static std::string _gameDirArg(const std::vector<std::string> &args, const ScummRp::Parameter *params);
+	static int _maxJobs();
+	static int _runJob(const std::string &name, const std::vector<std::string> &args, const char *toolName, int (*runFunc)(int, const char **), std::string &result);
+	static int _batch(const char *toolName, int (*runFunc)(int, const char **), const ScummRp::Parameter *params);
+	static void _scanDumpingDir();
+	static bool _inDumpingDir(std::string path, bool isDir);
 	static void _listGames();
 	static void _explore(TreeBlock &tree, int action);
 	template <int A> static void _exploreIndex(TreeBlock &index);
@@ -140,6 +203,7 @@ protected:
 
 public:
 	static int main(int argc, const char **argv);
+	static int run(int argc, const char **argv);
 
 private:
 	ScummRp();
@@ -37,7 +37,7 @@
  */
 
 TableOfContent::TableOfContent(TableOfContent::Type t) :
-    _toc(nullptr), _size(0), _type(t)
+    _roomIds(nullptr), _offsets(nullptr), _size(0), _type(t)
 {
 	_zap();
 }
@@ -51,12 +51,11 @@ TableOfContent &TableOfContent::operator=(const TableOfContent &t)
 {
 	_zap();
 
-	_size = t._size;
-	_toc = new TocElement[_size];
-	for (int i = 0; i < _size; ++i)
+	_alloc(t._size);
+	if (_size > 0)
 	{
-		_toc[i].roomId = t._toc[i].roomId;
-		_toc[i].offset = t._toc[i].offset;
+		std::memcpy(_roomIds, t._roomIds, _size * sizeof *_roomIds);
+		std::memcpy(_offsets, t._offsets, _size * sizeof *_offsets);
 	}
 
 	return *this;
@@ -106,7 +105,7 @@ void TableOfContent::merge(const TableOfContent &t)
 	std::memcpy(a, _accessed, sizeof a);
 	for (int i = 0; i < _size; ++i)
 	{
-		if (_toc[i].roomId != t._toc[i].roomId)
+		if (_roomIds[i] != t._roomIds[i])
 		{
 			// HACK: It appears that MONKEY1-VGA (v4) had bugs in its index packer,
 			// leaving dead entries not pointing at any block header.  For this
@@ -121,23 +120,23 @@ void TableOfContent::merge(const TableOfContent &t)
 			// See:
 			// - <https://github.com/dwatteau/scummtr/issues/54>
 			// - <https://github.com/dwatteau/scummtr/issues/69>
-			if (t._toc[i].roomId == (byte)-1 && t._toc[i].offset == -1 && ScummRp::game.id == GID_MONKEY && ScummRp::game.version == 4)
+			if (t._roomIds[i] == (byte)-1 && t._offsets[i] == -1 && ScummRp::game().id == GID_MONKEY && ScummRp::game().version == 4)
 			{
 				ScummIO::warning(xsprintf("Original dodgy room data found during TOC merge (%s #%i); ignoring it, but this is still experimental", TableOfContent::typeToStr(_type), i));
 			}
 			else
 			{
-				throw std::logic_error(xsprintf("TableOfContent::merge: different roomIds for TOC %i (%i vs %i)", i, _toc[i].roomId, t._toc[i].roomId));
+				throw std::logic_error(xsprintf("TableOfContent::merge: different roomIds for TOC %i (%i vs %i)", i, _roomIds[i], t._roomIds[i]));
 			}
 		}
 
-		if (t._accessed[_toc[i].roomId])
+		if (t._accessed[_roomIds[i]])
 		{
-			if (_accessed[_toc[i].roomId] && _toc[i].offset != t._toc[i].offset)
-				throw TableOfContent::Error(xsprintf("LFLF %i differently indexed from one file to another (offset %i vs %i)", _toc[i].roomId, _toc[i].offset, t._toc[i].offset));
+			if (_accessed[_roomIds[i]] && _offsets[i] != t._offsets[i])
+				throw TableOfContent::Error(xsprintf("LFLF %i differently indexed from one file to another (offset %i vs %i)", _roomIds[i], _offsets[i], t._offsets[i]));
 
-			_toc[i].offset = t._toc[i].offset;
-			a[_toc[i].roomId] = true;
+			_offsets[i] = t._offsets[i];
+			a[_roomIds[i]] = true;
 		}
 	}
 	std::memcpy(_accessed, a, sizeof a);
@@ -147,14 +146,24 @@ void TableOfContent::_zap()
 {
 	memset(_iterator, 0, sizeof _iterator);
 	memset(_accessed, 0, sizeof _accessed);
-	delete[] _toc;
-	_toc = nullptr;
+	delete[] _roomIds;
+	delete[] _offsets;
+	_roomIds = nullptr;
+	_offsets = nullptr;
 	_size = 0;
 }
 
+void TableOfContent::_alloc(int size)
+{
+	_zap();
+	_size = size;
+	_roomIds = new byte[_size];
+	_offsets = new int32[_size];
+}
+
 bool TableOfContent::_validItem(int id) const
 {
-	return _toc[id].offset > 0 && _toc[id].roomId != (byte)-1;
+	return _offsets[id] > 0 && _roomIds[id] != (byte)-1;
 }
 
 bool TableOfContent::_idInRange(int id) const
@@ -175,12 +184,12 @@ int TableOfContent::getSize() const
 	return _size;
 }
 
-TableOfContent::TocElement &TableOfContent::operator[](int id)
+TableOfContent::TocElementRef TableOfContent::operator[](int id)
 {
 	if (!_idInRange(id))
 		throw TableOfContent::InvalidId(xsprintf("TableOfContent::operator[]: Invalid Id: %i", id));
 
-	return _toc[id];
+	return TocElementRef(_roomIds[id], _offsets[id]);
 }
 
 TableOfContent::TocElement TableOfContent::operator[](int id) const
@@ -188,17 +197,18 @@ TableOfContent::TocElement TableOfContent::operator[](int id) const
 	if (!_idInRange(id))
 		throw TableOfContent::InvalidId(xsprintf("TableOfContent::operator[]: Invalid Id: %i", id));
 
-	return _toc[id];
+	TocElement e = { _roomIds[id], _offsets[id] };
+	return e;
 }
 
 int TableOfContent::count(byte roomId, int32 offset) const
 {
 	int total;
 
+	// no branch, so that the compiler may vectorize this loop
 	total = 0;
 	for (int i = 1; i < _size; ++i)
-		if (_toc[i].offset == offset && _toc[i].roomId == roomId)
-			++total;
+		total += (_offsets[i] == offset) & (_roomIds[i] == roomId);
 
 	return total;
 }
@@ -206,7 +216,7 @@ int TableOfContent::count(byte roomId, int32 offset) const
 int TableOfContent::findId(byte roomId, int32 offset) const
 {
 	for (int i = 1; i < _size; ++i)
-		if (_toc[i].offset == offset && _toc[i].roomId == roomId)
+		if (_offsets[i] == offset && _roomIds[i] == roomId)
 			return i;
 
 	throw TableOfContent::InvalidElement(xsprintf("TableOfContent::findId: Cannot find element (%u)", offset));
@@ -219,7 +229,7 @@ void TableOfContent::firstId(byte roomId)
 
 bool TableOfContent::nextId(int &id, byte roomId)
 {
-	while (_idInRange(_iterator[roomId]) && (_toc[_iterator[roomId]].roomId != roomId || !_validItem(_iterator[roomId])))
+	while (_idInRange(_iterator[roomId]) && (_roomIds[_iterator[roomId]] != roomId || !_validItem(_iterator[roomId])))
 		++_iterator[roomId];
 
 	id = _validId(_iterator[roomId]) ? _iterator[roomId]++ : TableOfContent::INVALID_ID;
@@ -227,6 +237,42 @@ bool TableOfContent::nextId(int &id, byte roomId)
 	return id != TableOfContent::INVALID_ID;
 }
 
+// The index blocks are read and written in one go, rather than entry by
+// entry, since every FilePart access costs a seek check and an XOR pass.
+// Interleaved entries are decoded from a buffer.
+
+static inline uint32 tocLE32(const byte *p)
+{
+	return (uint32)p[0] | ((uint32)p[1] << 8) | ((uint32)p[2] << 16) | ((uint32)p[3] << 24);
+}
+
+static inline void tocPutLE16(byte *p, uint16 w)
+{
+	p[0] = (byte)w;
+	p[1] = (byte)(w >> 8);
+}
+
+static inline void tocPutLE32(byte *p, uint32 i)
+{
+	p[0] = (byte)i;
+	p[1] = (byte)(i >> 8);
+	p[2] = (byte)(i >> 16);
+	p[3] = (byte)(i >> 24);
+}
+
+void TableOfContent::_readBuffer(FilePart &file, std::vector<byte> &buffer, int size)
+{
+	buffer.resize(size);
+	if (size > 0)
+		file.read((char *)&buffer[0], size);
+}
+
+void TableOfContent::_writeBuffer(FilePart &file, const std::vector<byte> &buffer)
+{
+	if (!buffer.empty())
+		file.write((const char *)&buffer[0], (std::streamsize)buffer.size());
+}
+
 void TableOfContent::_load16Sep32(FilePart &file)
 {
 	uint16 w;
@@ -235,14 +281,9 @@ void TableOfContent::_load16Sep32(FilePart &file)
 	try
 	{
 		file.getLE16(w);
-		_size = (int)w;
-		_toc = new TocElement[_size];
-
-		for (int i = 0; i < _size; ++i)
-			file.getByte(_toc[i].roomId);
-
-		for (int i = 0; i < _size; ++i)
-			file.getLE32(_toc[i].offset);
+		_alloc((int)w);
+		file.read((char *)_roomIds, _size);
+		file.readLE32Array(_offsets, _size);
 	}
 	catch (...)
 	{
@@ -253,19 +294,23 @@ void TableOfContent::_load16Sep32(FilePart &file)
 
 void TableOfContent::_save16Sep32(FilePart &file) const
 {
-	file.putLE16((uint16)_size);
+	std::vector<byte> buffer(2 + _size * 5);
+
+	tocPutLE16(&buffer[0], (uint16)_size);
 
 	for (int i = 0; i < _size; ++i)
-		file.putByte(_toc[i].roomId);
+		buffer[2 + i] = _roomIds[i];
 
 	for (int i = 0; i < _size; ++i)
-		file.putLE32(_toc[i].offset);
+		tocPutLE32(&buffer[2 + _size + 4 * i], (uint32)_offsets[i]);
+
+	_writeBuffer(file, buffer);
 }
 
 void TableOfContent::_load8Sep16(FilePart &file, int size)
 {
+	std::vector<uint16> offsets;
 	byte b;
-	uint16 w;
 
 	_zap();
 	try
@@ -273,22 +318,17 @@ void TableOfContent::_load8Sep16(FilePart &file, int size)
 		if (size == 0)
 		{
 			file.getByte(b);
-			_size = (int)b;
-		}
-		else
-		{
-			_size = size;
+			size = (int)b;
 		}
-		_toc = new TocElement[_size];
+		_alloc(size);
+		file.read((char *)_roomIds, _size);
 
-		for (int i = 0; i < _size; ++i)
-			file.getByte(_toc[i].roomId);
+		offsets.resize(_size);
+		if (_size > 0)
+			file.readLE16Array(&offsets[0], _size);
 
 		for (int i = 0; i < _size; ++i)
-		{
-			file.getLE16(w);
-			_toc[i].offset = (w == 0xFFFF) ? -1 : (int32)w;
-		}
+			_offsets[i] = (offsets[i] == 0xFFFF) ? -1 : (int32)offsets[i];
 	}
 	catch (...)
 	{
@@ -299,14 +339,46 @@ void TableOfContent::_load8Sep16(FilePart &file, int size)
 
 void TableOfContent::_save8Sep16(FilePart &file, bool fixedSize) const
 {
+	std::vector<byte> buffer;
+	int pos;
+
+	pos = fixedSize ? 0 : 1;
+	buffer.resize(pos + _size * 3);
 	if (!fixedSize)
-		file.putByte((byte)_size);
+		buffer[0] = (byte)_size;
 
 	for (int i = 0; i < _size; ++i)
-		file.putByte(_toc[i].roomId);
+		buffer[pos + i] = _roomIds[i];
 
 	for (int i = 0; i < _size; ++i)
-		file.putLE16((uint16)_toc[i].offset);
+		tocPutLE16(&buffer[pos + _size + 2 * i], (uint16)_offsets[i]);
+
+	_writeBuffer(file, buffer);
+}
+
+void TableOfContent::_loadMix32(FilePart &file, int size)
+{
+	std::vector<byte> buffer;
+
+	_alloc(size);
+	_readBuffer(file, buffer, _size * 5);
+
+	for (int i = 0; i < _size; ++i)
+	{
+		_roomIds[i] = buffer[5 * i];
+		_offsets[i] = (int32)tocLE32(&buffer[5 * i + 1]);
+	}
+}
+
+void TableOfContent::_saveMix32(std::vector<byte> &buffer, int pos) const
+{
+	buffer.resize(pos + _size * 5);
+
+	for (int i = 0; i < _size; ++i)
+	{
+		buffer[pos + 5 * i] = _roomIds[i];
+		tocPutLE32(&buffer[pos + 5 * i + 1], (uint32)_offsets[i]);
+	}
 }
 
 void TableOfContent::_load8Mix32(FilePart &file)
@@ -317,14 +389,7 @@ void TableOfContent::_load8Mix32(FilePart &file)
 	try
 	{
 		file.getByte(b);
-		_size = (int)b;
-
-		_toc = new TocElement[_size];
-		for (int i = 0; i < _size; ++i)
-		{
-			file.getByte(_toc[i].roomId);
-			file.getLE32(_toc[i].offset);
-		}
+		_loadMix32(file, (int)b);
 	}
 	catch (...)
 	{
@@ -335,13 +400,11 @@ void TableOfContent::_load8Mix32(FilePart &file)
 
 void TableOfContent::_save8Mix32(FilePart &file) const
 {
-	file.putByte((byte)_size);
+	std::vector<byte> buffer;
 
-	for (int i = 0; i < _size; ++i)
-	{
-		file.putByte(_toc[i].roomId);
-		file.putLE32(_toc[i].offset);
-	}
+	_saveMix32(buffer, 1);
+	buffer[0] = (byte)_size;
+	_writeBuffer(file, buffer);
 }
 
 void TableOfContent::_load16Mix32(FilePart &file)
@@ -352,14 +415,7 @@ void TableOfContent::_load16Mix32(FilePart &file)
 	try
 	{
 		file.getLE16(w);
-		_size = (int)w;
-
-		_toc = new TocElement[_size];
-		for (int i = 0; i < _size; ++i)
-		{
-			file.getByte(_toc[i].roomId);
-			file.getLE32(_toc[i].offset);
-		}
+		_loadMix32(file, (int)w);
 	}
 	catch (...)
 	{
@@ -370,13 +426,11 @@ void TableOfContent::_load16Mix32(FilePart &file)
 
 void TableOfContent::_save16Mix32(FilePart &file) const
 {
-	file.putLE16((uint16)_size);
+	std::vector<byte> buffer;
 
-	for (int i = 0; i < _size; ++i)
-	{
-		file.putByte(_toc[i].roomId);
-		file.putLE32(_toc[i].offset);
-	}
+	_saveMix32(buffer, 2);
+	tocPutLE16(&buffer[0], (uint16)_size);
+	_writeBuffer(file, buffer);
 }
 
 void TableOfContent::load(FilePart &file, GlobalTocFormat format, int size)
@@ -459,6 +513,13 @@ GlobalRoomIndex::~GlobalRoomIndex()
 	_zap();
 }
 
+GlobalRoomIndex &GlobalRoomIndex::operator=(const GlobalRoomIndex &t)
+{
+	TableOfContent::operator=(t);
+
+	return *this;
+}
+
 void GlobalRoomIndex::_zap()
 {
 	TableOfContent::_zap();
@@ -471,10 +532,10 @@ void GlobalRoomIndex::merge(const TableOfContent &t)
 	{
 		if (t.accessed((byte)i))
 		{
-			if (_accessed[i] && _toc[i].offset != t[i].offset)
-				throw TableOfContent::Error(xsprintf("LFLF %i differently indexed from one file to another (offset %i vs %i)", i, _toc[i].offset, t[i].offset));
+			if (_accessed[i] && _offsets[i] != t[i].offset)
+				throw TableOfContent::Error(xsprintf("LFLF %i differently indexed from one file to another (offset %i vs %i)", i, _offsets[i], t[i].offset));
 
-			_toc[i].offset = t[i].offset;
+			_offsets[i] = t[i].offset;
 			_accessed[i] = true;
 		}
 	}
@@ -506,7 +567,7 @@ bool GlobalRoomIndex::nextId(int &id, byte roomId)
 	return true;
 }
 
-TableOfContent::TocElement &GlobalRoomIndex::operator[](int id)
+TableOfContent::TocElementRef GlobalRoomIndex::operator[](int id)
 {
 	if (id >= _size)
 		throw GlobalRoomIndex::IndexTooShort("Room index too short");
@@ -532,7 +593,7 @@ void GlobalRoomIndex::load(FilePart &file, GlobalTocFormat format, int size)
 	// hack for V1
 	if (size > 0) // means V1
 		for (int i = 0; i < _size; ++i)
-			_toc[i].offset = 0;
+			_offsets[i] = 0;
 }
 
 void GlobalRoomIndex::save(FilePart &file, GlobalTocFormat format, bool fixedSize)
@@ -549,17 +610,17 @@ int GlobalRoomIndex::numberOfDisks() const
 	max = 0;
 	for (int i = 0; i < _size; ++i)
 	{
-		if (_toc[i].roomId > max)
+		if (_roomIds[i] > max)
 		{
 			// Ignore the requirement on DISK09.LEC for MONKEY1-EGA: it was only available with
 			// the "Roland Update" and we don't need its content here.
-			if (i == 94 && _toc[i].roomId == 9 && ScummRp::game.id == GID_MONKEY && ScummRp::game.version == 4)
+			if (i == 94 && _roomIds[i] == 9 && ScummRp::game().id == GID_MONKEY && ScummRp::game().version == 4)
 			{
 				ScummIO::info(INF_DETAIL, "Ignoring dependency on DISK09.LEC");
 				continue;
 			}
 
-			max = _toc[i].roomId;
+			max = _roomIds[i];
 		}
 	}
 
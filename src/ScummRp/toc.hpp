@@ -33,6 +33,7 @@
 
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 /*
  * TableOfContent
@@ -49,6 +50,19 @@ public:
 		byte roomId;
 		int32 offset;
 	};
+	// entries are stored as two separate arrays; this gives access to
+	// both fields of one of them
+	struct TocElementRef
+	{
+		byte &roomId;
+		int32 &offset;
+
+		TocElementRef(byte &r, int32 &o) : roomId(r), offset(o) { }
+		operator TableOfContent::TocElement() const { TableOfContent::TocElement e = { roomId, offset }; return e; }
+
+	private:
+		TocElementRef &operator=(const TocElementRef &);
+	};
 	enum Type
 	{
 		TOCT_NULL = 0,
@@ -78,7 +92,8 @@ public:
 	};
 
 protected:
-	TocElement *_toc;
+	byte *_roomIds;
+	int32 *_offsets;
 	int _size;
 	TableOfContent::Type _type;
 	int _iterator[256];
@@ -88,10 +103,15 @@ protected:
 	bool _idInRange(int id) const;
 	bool _validItem(int id) const;
 	bool _validId(int id) const;
+	void _alloc(int size);
+	static void _readBuffer(FilePart &file, std::vector<byte> &buffer, int size);
+	static void _writeBuffer(FilePart &file, const std::vector<byte> &buffer);
 	void _load16Sep32(FilePart &file);
 	void _load8Sep16(FilePart &file, int size);
 	void _load8Mix32(FilePart &file);
 	void _load16Mix32(FilePart &file);
+	void _loadMix32(FilePart &file, int size);
+	void _saveMix32(std::vector<byte> &buffer, int pos) const;
 	void _save16Sep32(FilePart &file) const;
 	void _save8Sep16(FilePart &file, bool fixedSize) const;
 	void _save8Mix32(FilePart &file) const;
@@ -113,7 +133,7 @@ public:
 	virtual int findId(byte roomId, int32 offset) const;
 	virtual void firstId(byte roomId);
 	virtual bool nextId(int &id, byte roomId);
-	virtual TableOfContent::TocElement &operator[](int id);
+	virtual TableOfContent::TocElementRef operator[](int id);
 	virtual TableOfContent::TocElement operator[](int id) const;
 	virtual void load(FilePart &file, GlobalTocFormat format, int size);
 	virtual void save(FilePart &file, GlobalTocFormat format, bool fixedSize);
@@ -155,7 +175,7 @@ protected:
 	void _zap() override;
 
 public:
-	TableOfContent::TocElement &operator[](int id) override;
+	TableOfContent::TocElementRef operator[](int id) override;
 	TableOfContent::TocElement operator[](int id) const override;
 	void merge(const TableOfContent &t) override;
 	int count(byte roomId, int32 offset) const override;
@@ -23,6 +23,7 @@
  *
  */
 
+#include "common/stats.hpp"
 #include "ScummRp/scummrp.hpp"
 
 #include "script.hpp"
@@ -35,15 +36,14 @@
  */
 
 Script::Script() :
-    _file(nullptr), _text(), _jump(), _spot(),
-    _log(true), _gettingRscNameLimits(false), _usingRscNameLimits(false)
-
+    _game(ScummRp::game()), _file(nullptr), _text(), _jump(), _spot(),
+    _log(true)
 {
 }
 
 Script::Script(FilePart &f, std::streamoff o, std::streamsize s) :
-    _file(new FilePart(f, o, s)), _text(), _jump(), _spot(),
-    _log(true), _gettingRscNameLimits(false), _usingRscNameLimits(false)
+    _game(ScummRp::game()), _file(new FilePart(f, o, s)), _text(), _jump(), _spot(),
+    _log(true)
 {
 }
 
@@ -55,7 +55,7 @@ void Script::_updateJumps(int32 offset, int32 diff, int lineNumber)
 {
 	int32 val;
 
-	for (std::list<JumpRef>::iterator i = _jump.begin(); i != _jump.end(); ++i)
+	for (std::vector<JumpRef>::iterator i = _jump.begin(); i != _jump.end(); ++i)
 	{
 		if (i->target >= offset)
 			i->target += diff;
@@ -77,7 +77,7 @@ void Script::_writeJumps(std::string &buffer)
 {
 	int32 val;
 
-	for (std::list<JumpRef>::iterator i = _jump.begin(); i != _jump.end(); ++i)
+	for (std::vector<JumpRef>::iterator i = _jump.begin(); i != _jump.end(); ++i)
 	{
 		val = i->target - i->offset - 2;
 		buffer[i->offset] = (char)(byte)(val & 0xFF);
@@ -97,7 +97,7 @@ void Script::importText(Text &input)
 
 	totalDiff = 0;
 	lastEnd = 0;
-	for (std::list<StringRef>::iterator i = _text.begin(); i != _text.end(); ++i)
+	for (std::vector<StringRef>::iterator i = _text.begin(); i != _text.end(); ++i)
 	{
 		if (!input.nextLine(s, i->type))
 			throw Script::Error("Not enough lines in imported text");
@@ -135,49 +135,51 @@ void Script::importText(Text &input)
 	_file->write(buffer);
 }
 
+// With padding, the name limits are collected from the same parse, and the
+// padding itself is left to the output (see Text::deferLines())
 void Script::exportText(Text &output, bool pad)
 {
 	std::string s;
 
-	_usingRscNameLimits = pad;
-	try
-	{
+	if (pad)
+		getRscNameLimits();
+	else
 		parse();
-	}
-	catch (...)
-	{
-		_usingRscNameLimits = false;
-		throw;
-	}
-	_usingRscNameLimits = false;
 
-	for (std::list<StringRef>::iterator i = _text.begin(); i != _text.end(); ++i)
+	for (std::vector<StringRef>::iterator i = _text.begin(); i != _text.end(); ++i)
 	{
 		_file->seekg(i->offset, std::ios::beg);
 		_file->read(s, i->length - 1);
 
-		if (pad && i->padding > i->length - 1)
-			s.resize(i->padding, '@');
-
-		output.addLine(s, i->type, i->opcode);
+		if (pad)
+			output.addLine(s, i->type, i->opcode, i->rscType, i->rscId);
+		else
+			output.addLine(s, i->type, i->opcode);
 	}
 }
 
+// A script which cannot be fully parsed still gives the limits found before
+// the error, since the other scripts may use the same names
 void Script::getRscNameLimits()
 {
-	_gettingRscNameLimits = true;
-
 	try
 	{
 		parse();
 	}
 	catch (...)
 	{
-		_gettingRscNameLimits = false;
+		_setRscNameLimits();
 		throw;
 	}
 
-	_gettingRscNameLimits = false;
+	_setRscNameLimits();
+}
+
+void Script::_setRscNameLimits() const
+{
+	for (std::vector<StringRef>::const_iterator i = _text.begin(); i != _text.end(); ++i)
+		if (i->rscType >= 0)
+			ScummTr::setRscNameMaxLengh((ScummTr::RscType)i->rscType, i->rscId, i->length - 1);
 }
 
 void Script::setTrackedSpots(const std::list<int32> &spots)
@@ -195,7 +197,7 @@ void Script::getTrackedSpots(std::list<int32> &spots) const
 #ifdef SCUMMTR_CHECK_SCRIPT_JUMPS
 void Script::_checkJumps()
 {
-	std::list<JumpRef>::iterator i;
+	std::vector<JumpRef>::iterator i;
 	int32 pos;
 	int count, n;
 
@@ -206,7 +208,7 @@ void Script::_checkJumps()
 	_log = false;
 	try
 	{
-		if (ScummRp::game.version <= 2)
+		if (_game.version <= 2)
 		{
 #ifdef SCUMMTR_CHANGED_JUST_AFTER_RELEASE
 			while ((pos = _file->tellg(std::ios::end)) < 0 && count < n)
@@ -220,7 +222,7 @@ void Script::_checkJumps()
 				_opv12();
 			}
 		}
-		else if (ScummRp::game.version <= 5)
+		else if (_game.version <= 5)
 		{
 #ifdef SCUMMTR_CHANGED_JUST_AFTER_RELEASE
 			while ((pos = _file->tellg(std::ios::end)) < 0 && count < n)
@@ -234,7 +236,7 @@ void Script::_checkJumps()
 				_opv345();
 			}
 		}
-		else if (ScummRp::game.version <= 7)
+		else if (_game.version <= 7)
 		{
 #ifdef SCUMMTR_CHANGED_JUST_AFTER_RELEASE
 			while ((pos = _file->tellg(std::ios::end)) < 0 && count < n)
@@ -266,6 +268,14 @@ void Script::_checkJumps()
 #pragma GCC diagnostic ignored "-Wformat"
 #endif
 void Script::parse()
+{
+	ScummStats::Timer timer(ScummStats::PHS_SCRIPT_PARSE);
+
+	ScummStats::count(ScummStats::CNT_SCRIPTS);
+	_parse();
+}
+
+void Script::_parse()
 {
 	_text.resize(0);
 	_jump.resize(0);
@@ -273,14 +283,14 @@ void Script::parse()
 
 	try
 	{
-		if (ScummRp::game.version <= 2)
+		if (_game.version <= 2)
 #ifdef SCUMMTR_CHANGED_JUST_AFTER_RELEASE
 			while (_file->tellg(std::ios::end) < 0)
 #else
 			while (_file->tellg(std::ios::beg) < _file->size())
 #endif
 				_opv12();
-		else if (ScummRp::game.version <= 5)
+		else if (_game.version <= 5)
 #ifdef SCUMMTR_CHANGED_JUST_AFTER_RELEASE
 			while (_file->tellg(std::ios::end) < 0)
 
@@ -288,7 +298,7 @@ void Script::parse()
 			while (_file->tellg(std::ios::beg) < _file->size())
 #endif
 				_opv345();
-		else if (ScummRp::game.version <= 7)
+		else if (_game.version <= 7)
 #ifdef SCUMMTR_CHANGED_JUST_AFTER_RELEASE
 			while (_file->tellg(std::ios::end) < 0)
 #else
@@ -362,9 +372,9 @@ int32 Script::_eatWordOrVar(byte flag)
 
 void Script::_eatVar()
 {
-	if (ScummRp::game.version <= 2)
+	if (_game.version <= 2)
 		_getByte();
-	else if ((_getWord() & 0x2000) && ScummRp::game.version <= 5)
+	else if ((_getWord() & 0x2000) && _game.version <= 5)
 		_getWord();
 }
 
@@ -413,6 +423,16 @@ int32 Script::_eatString(Text::LineType stringType, byte opcode)
 	return (_log) ? length : 0;
 }
 
+// Remembers which resource the last string names, for padding
+void Script::_rscName(int rscType, int32 rscId)
+{
+	if (!_log)
+		return;
+
+	_text.back().rscType = rscType;
+	_text.back().rscId = rscId;
+}
+
 /*
  * regexp
  *
@@ -720,7 +740,7 @@ void Script::_opv67()
 		case 233:
 		case 234:
 		case 235:
-			if (ScummRp::game.version <= 6)
+			if (_game.version <= 6)
 				throw Script::ParseError("actorOps case > 197");
 			break;
 		default:
@@ -752,7 +772,7 @@ void Script::_opv67()
 		case 196:
 			break;
 		case 255:
-			if (ScummRp::game.id != GID_TENTACLE)
+			if (_game.id != GID_TENTACLE)
 				throw Script::ParseError("verbOps case 0xFF");
 			break;
 		default:
@@ -935,7 +955,7 @@ void Script::_opv67()
 		_getByte();
 		throw Script::ParseError(xsprintf("unknown%.2X", opcode));
 	case 0xE1: // unknownE1
-		if (ScummRp::game.id != GID_DIG)
+		if (_game.id != GID_DIG)
 			throw Script::ParseError(xsprintf("unknown%.2X", opcode));
 		break;
 	case 0xE2: // localizeArray
@@ -1048,7 +1068,7 @@ void Script::_opv12()
 	case 0x4B: // setObjPreposition
 	case 0x8B: // setObjPreposition
 	case 0xCB: // setObjPreposition
-		if (ScummRp::game.version == 1 && ScummRp::game.id == GID_MANIAC)
+		if (_game.version == 1 && _game.id == GID_MANIAC)
 			throw Script::ParseError(xsprintf("Unknown opcode 0x%.2X", opcode));
 		_eatWordOrVar(opcode & 0x80);
 		_getByte();
@@ -1108,18 +1128,13 @@ void Script::_opv12()
 			case 0x01:
 				break;
 			case 0x02:
-				if (ScummRp::game.version == 2)
+				if (_game.version == 2)
 					_getByte();
 				break;
 			case 0x03:
 				l = _eatString(Text::LT_PLAIN, mainOpcode);
 				if (l > 0)
-				{
-					if (_gettingRscNameLimits)
-						ScummTr::setRscNameMaxLengh(ScummTr::RSCT_ACTOR, actor, l);
-					else if (_usingRscNameLimits)
-						_text.back().padding = ScummTr::getRscNameMaxLengh(ScummTr::RSCT_ACTOR, actor);
-				}
+					_rscName(ScummTr::RSCT_ACTOR, actor);
 				break;
 			case 0x04:
 			case 0x05:
@@ -1289,12 +1304,12 @@ void Script::_opv12()
 		_eatWordOrVar(opcode & 0x80);
 		break;
 	case 0x2B: // delayVariable
-		if (ScummRp::game.version == 1 && ScummRp::game.id == GID_MANIAC)
+		if (_game.version == 1 && _game.id == GID_MANIAC)
 			throw Script::ParseError(xsprintf("Unknown opcode 0x%.2X", opcode));
 		_eatVar();
 		break;
 	case 0x2C: // assignVarByte
-		if (ScummRp::game.version == 1 && ScummRp::game.id == GID_MANIAC)
+		if (_game.version == 1 && _game.id == GID_MANIAC)
 			throw Script::ParseError(xsprintf("Unknown opcode 0x%.2X", opcode));
 		_eatVar();
 		_getByte();
@@ -1459,12 +1474,7 @@ void Script::_opv12()
 			obj = _eatWordOrVar(opcode & 0x80);
 			l = _eatString(Text::LT_PLAIN, mainOpcode);
 			if (l > 0)
-			{
-				if (_gettingRscNameLimits)
-					ScummTr::setRscNameMaxLengh(ScummTr::RSCT_OBJECT, obj, l);
-				else if (_usingRscNameLimits)
-					_text.back().padding = ScummTr::getRscNameMaxLengh(ScummTr::RSCT_OBJECT, obj);
-			}
+				_rscName(ScummTr::RSCT_OBJECT, obj);
 		}
 		break;
 	case 0x56: // getActorMoving
@@ -1522,7 +1532,7 @@ void Script::_opv12()
 		break;
 	case 0x6C: // getObjPreposition
 	case 0xEC: // getObjPreposition
-		if (ScummRp::game.version == 1 && ScummRp::game.id == GID_MANIAC)
+		if (_game.version == 1 && _game.id == GID_MANIAC)
 			throw Script::ParseError(xsprintf("Unknown opcode 0x%.2X", opcode));
 		_eatVar();
 		_eatWordOrVar(opcode & 0x80);
@@ -1580,12 +1590,7 @@ void Script::_opv12()
 				_getByte();
 				l = _eatString(Text::LT_PLAIN, mainOpcode);
 				if (l > 0)
-				{
-					if (_gettingRscNameLimits)
-						ScummTr::setRscNameMaxLengh(ScummTr::RSCT_VERB, verb, l);
-					else if (_usingRscNameLimits)
-						_text.back().padding = ScummTr::getRscNameMaxLengh(ScummTr::RSCT_VERB, verb);
-				}
+					_rscName(ScummTr::RSCT_VERB, verb);
 			}
 		}
 		break;
@@ -1609,13 +1614,13 @@ void Script::_opv12()
 		_eatJump();
 		break;
 	case 0xAB: // switchCostumeSet // TODO check this
-		if (ScummRp::game.features & GF_NES)
+		if (_game.features & GF_NES)
 			_getByte();
 		else
 			throw Script::ParseError("switchCostumeSet");
 		break;
 	case 0xAC: // drawSentence
-		if (ScummRp::game.version == 1 && ScummRp::game.id == GID_MANIAC)
+		if (_game.version == 1 && _game.id == GID_MANIAC)
 			throw Script::ParseError(xsprintf("Unknown opcode 0x%.2X", opcode));
 		break;
 	case 0xAE: // waitForMessage
@@ -1663,7 +1668,7 @@ void Script::_opv345(int r)
 		break;
 	case 0x02: // startMusic
 	case 0x82: // startMusic
-		if ((ScummRp::game.features & GF_FMTOWNS) && ScummRp::game.version == 3)
+		if ((_game.features & GF_FMTOWNS) && _game.version == 3)
 		{
 			_eatVar();
 			_eatByteOrVar(opcode & 0x80);
@@ -1688,7 +1693,7 @@ void Script::_opv345(int r)
 	case 0x65: // pickupObject
 	case 0xA5: // pickupObject
 	case 0xE5: // pickupObject
-		if (ScummRp::game.version == 5)
+		if (_game.version == 5)
 		{
 			_eatWordOrVar(opcode & 0x80);
 			_eatByteOrVar(opcode & 0x40);
@@ -1701,7 +1706,7 @@ void Script::_opv345(int r)
 	case 0x85: // drawObject
 	case 0xC5: // drawObject
 		_eatWordOrVar(opcode & 0x80);
-		if (ScummRp::game.version <= 4)
+		if (_game.version <= 4)
 		{
 			_eatWordOrVar(opcode & 0x40);
 			_eatWordOrVar(opcode & 0x20);
@@ -1775,7 +1780,7 @@ void Script::_opv345(int r)
 		if (opcode != 0x11)
 			_eatByteOrVar(opcode & 0x80);
 
-		if (!(ScummRp::game.features & GF_FMTOWNS))
+		if (!(_game.features & GF_FMTOWNS))
 			if ((opcode & 0x3F) != (opcode & 0x1F))
 				throw Script::ParseError("resourceRoutines");
 
@@ -1790,7 +1795,7 @@ void Script::_opv345(int r)
 		case 0x07:
 			break;
 		case 0x08:
-			if (ScummRp::game.features & GF_FMTOWNS)
+			if (_game.features & GF_FMTOWNS)
 				throw Script::ParseError("resourceRoutines case 0x08");
 			break;
 		case 0x09:
@@ -1813,7 +1818,7 @@ void Script::_opv345(int r)
 		case 0x21:
 			throw Script::ParseError("resourceRoutines case 0x21");
 		case 0x23:
-			if (ScummRp::game.id == GID_INDY3)
+			if (_game.id == GID_INDY3)
 				throw Script::ParseError("resourceRoutines case 0x23");
 			_eatByteOrVar(opcode & 0x40);
 			break;
@@ -1845,7 +1850,7 @@ void Script::_opv345(int r)
 		break;
 	case 0x0F: // getObjectState
 	case 0x8F: // getObjectState
-		if (ScummRp::game.version <= 4)
+		if (_game.version <= 4)
 		{ // ifState
 			_eatWordOrVar(opcode & 0x80);
 			_eatByteOrVar(opcode & 0x40);
@@ -1894,7 +1899,7 @@ void Script::_opv345(int r)
 			actor = _eatByteOrVar(opcode & 0x80);
 			while ((opcode = _getByte()) != 0xFF)
 			{
-				if (ScummRp::game.version <= 4)
+				if (_game.version <= 4)
 					opcode = (opcode & 0xE0) | convertTable[(opcode & 0x1F)];
 
 				switch (opcode & 0x1F)
@@ -1940,12 +1945,7 @@ void Script::_opv345(int r)
 				case 0x0D:
 					l = _eatString(Text::LT_RSC, mainOpcode);
 					if (l > 0)
-					{
-						if (_gettingRscNameLimits)
-							ScummTr::setRscNameMaxLengh(ScummTr::RSCT_ACTOR, actor, l);
-						else if (_usingRscNameLimits)
-							_text.back().padding = ScummTr::getRscNameMaxLengh(ScummTr::RSCT_ACTOR, actor);
-					}
+						_rscName(ScummTr::RSCT_ACTOR, actor);
 					break;
 				case 0x0E:
 					_eatByteOrVar(opcode & 0x80);
@@ -1957,16 +1957,16 @@ void Script::_opv345(int r)
 					_eatByteOrVar(opcode & 0x80);
 					break;
 				case 0x11:
-					if (ScummRp::game.version == 4)
+					if (_game.version == 4)
 					{
 						_eatByteOrVar(opcode & 0x80);
 					}
-					else if (ScummRp::game.version == 5)
+					else if (_game.version == 5)
 					{
 						_eatByteOrVar(opcode & 0x80);
 						_eatByteOrVar(opcode & 0x40);
 					}
-					else // (ScummRp::game.version == 3)
+					else // (_game.version == 3)
 					{
 						throw Script::ParseError("actorSet case 0x11");
 					}
@@ -2016,7 +2016,7 @@ void Script::_opv345(int r)
 			case 0x4:
 				break;
 			case 0x6:
-				if (ScummRp::game.version == 3) // Used in Loom only
+				if (_game.version == 3) // Used in Loom only
 					_eatWordOrVar(opcode & 0x80);
 				break;
 			case 0x7:
@@ -2122,7 +2122,7 @@ void Script::_opv345(int r)
 	case 0x23: // getActorY
 	case 0xA3: // getActorY
 		_eatVar();
-		if (ScummRp::game.id == GID_INDY3 && !(ScummRp::game.features & GF_MACINTOSH))
+		if (_game.id == GID_INDY3 && !(_game.features & GF_MACINTOSH))
 			_eatByteOrVar(opcode & 0x80);
 		else
 			_eatWordOrVar(opcode & 0x80);
@@ -2212,7 +2212,7 @@ void Script::_opv345(int r)
 		case 0x0A:
 			_eatByteOrVar(opcode & 0x80);
 			_eatByteOrVar(opcode & 0x40);
-			if (ScummRp::game.id != GID_LOOM)
+			if (_game.id != GID_LOOM)
 				throw Script::ParseError("cursorCommand case 0x0A");
 			break;
 		case 0x0B:
@@ -2225,7 +2225,7 @@ void Script::_opv345(int r)
 			_eatByteOrVar(opcode & 0x80);
 			break;
 		case 0x0E:
-			if (ScummRp::game.version == 3)
+			if (_game.version == 3)
 			{
 				_eatByteOrVar(opcode & 0x80);
 				_eatByteOrVar(opcode & 0x40);
@@ -2261,7 +2261,7 @@ void Script::_opv345(int r)
 		break;
 	case 0x30: // matrixOps
 	case 0xB0: // matrixOps
-		if (ScummRp::game.version == 3)
+		if (_game.version == 3)
 		{
 			_eatByteOrVar(opcode & 0x80);
 			_getByte();
@@ -2295,50 +2295,50 @@ void Script::_opv345(int r)
 	case 0x73: // roomOps
 	case 0xB3: // roomOps
 	case 0xF3: // roomOps
-		if (ScummRp::game.version == 3)
+		if (_game.version == 3)
 		{
 			_eatWordOrVar(opcode & 0x80);
 			_eatWordOrVar(opcode & 0x40);
 		}
 
 		opcode = _getByte();
-		if (ScummRp::game.version == 3 && (opcode & 0x1F) > 6)
+		if (_game.version == 3 && (opcode & 0x1F) > 6)
 			throw Script::ParseError("roomOps case > 6");
 
 		switch (opcode & 0x1F)
 		{
 		case 0x01:
-			if (ScummRp::game.version > 3)
+			if (_game.version > 3)
 			{
 				_eatWordOrVar(opcode & 0x80);
 				_eatWordOrVar(opcode & 0x40);
 			}
 			break;
 		case 0x02:
-			if (ScummRp::game.version == 4)
+			if (_game.version == 4)
 			{
 				_eatWordOrVar(opcode & 0x80);
 				_eatWordOrVar(opcode & 0x40);
 			}
-			else if (ScummRp::game.version == 5)
+			else if (_game.version == 5)
 			{
 				throw Script::ParseError("roomOps case 0x02");
 			}
 			break;
 		case 0x03:
-			if (ScummRp::game.version > 3)
+			if (_game.version > 3)
 			{
 				_eatWordOrVar(opcode & 0x80);
 				_eatWordOrVar(opcode & 0x40);
 			}
 			break;
 		case 0x04:
-			if (ScummRp::game.version == 4)
+			if (_game.version == 4)
 			{
 				_eatWordOrVar(opcode & 0x80);
 				_eatWordOrVar(opcode & 0x40);
 			}
-			else if (ScummRp::game.version == 5)
+			else if (_game.version == 5)
 			{
 				_eatWordOrVar(opcode & 0x80);
 				_eatWordOrVar(opcode & 0x40);
@@ -2360,9 +2360,9 @@ void Script::_opv345(int r)
 			_eatByteOrVar(opcode & 0x40);
 			break;
 		case 0x08:
-			if (ScummRp::game.version <= 4)
+			if (_game.version <= 4)
 			{
-				if (ScummRp::game.version != 3)
+				if (_game.version != 3)
 				{
 					_eatWordOrVar(opcode & 0x80);
 					_eatWordOrVar(opcode & 0x40);
@@ -2457,12 +2457,12 @@ void Script::_opv345(int r)
 		break;
 	case 0x3B: // getActorScale
 	case 0xBB: // getActorScale
-		if (ScummRp::game.id == GID_LOOM)
+		if (_game.id == GID_LOOM)
 			break;
 
-		if (ScummRp::game.id == GID_INDY3)
+		if (_game.id == GID_INDY3)
 		{
-			if (ScummRp::game.features & GF_MACINTOSH)
+			if (_game.features & GF_MACINTOSH)
 				throw Script::ParseError("getActorScale");
 
 			_eatByteOrVar(opcode & 0x80);
@@ -2507,7 +2507,7 @@ void Script::_opv345(int r)
 	case 0x43: // getActorX
 	case 0xC3: // getActorX
 		_eatVar();
-		if (ScummRp::game.id == GID_INDY3 && !(ScummRp::game.features & GF_MACINTOSH))
+		if (_game.id == GID_INDY3 && !(_game.features & GF_MACINTOSH))
 			_eatByteOrVar(opcode & 0x80);
 		else
 			_eatWordOrVar(opcode & 0x80);
@@ -2528,7 +2528,7 @@ void Script::_opv345(int r)
 		_eatJump();
 		break;
 	case 0x4C: // soundKludge
-		if (ScummRp::game.version >= 5)
+		if (_game.version >= 5)
 			_eatArgList();
 		break;
 	case 0x4F: // ifState
@@ -2553,12 +2553,7 @@ void Script::_opv345(int r)
 			obj = _eatWordOrVar(opcode & 0x80);
 			l = _eatString(Text::LT_RSC, mainOpcode);
 			if (l > 0)
-			{
-				if (_gettingRscNameLimits)
-					ScummTr::setRscNameMaxLengh(ScummTr::RSCT_OBJECT, obj, l);
-				else if (_usingRscNameLimits)
-					_text.back().padding = ScummTr::getRscNameMaxLengh(ScummTr::RSCT_OBJECT, obj);
-			}
+				_rscName(ScummTr::RSCT_OBJECT, obj);
 		}
 		break;
 	case 0x56: // getActorMoving
@@ -2668,12 +2663,7 @@ void Script::_opv345(int r)
 				case 0x02:
 					l = _eatString(Text::LT_RSC, mainOpcode);
 					if (l > 0)
-					{
-						if (_gettingRscNameLimits)
-							ScummTr::setRscNameMaxLengh(ScummTr::RSCT_VERB, verb, l);
-						else if (_usingRscNameLimits)
-							_text.back().padding = ScummTr::getRscNameMaxLengh(ScummTr::RSCT_VERB, verb);
-					}
+						_rscName(ScummTr::RSCT_VERB, verb);
 					break;
 				case 0x03:
 				case 0x04:
@@ -2702,7 +2692,7 @@ void Script::_opv345(int r)
 					_eatWordOrVar(opcode & 0x80);
 					break;
 				case 0x15:
-					if (ScummRp::game.id == GID_LOOM && ScummRp::game.version == 4)
+					if (_game.id == GID_LOOM && _game.version == 4)
 					{
 						_getByte();
 						_getByte();
@@ -2747,7 +2737,7 @@ void Script::_opv345(int r)
 		}
 		break;
 	case 0xA7: // saveLoadVars
-		if (ScummRp::game.version != 3)
+		if (_game.version != 3)
 			throw Script::ParseError("saveLoadVars");
 
 		_getByte();
@@ -2822,7 +2812,7 @@ void Script::_opv345(int r)
 		}
 		break;
 	case 0xAE: // wait
-		if (ScummRp::game.id == GID_INDY3 && !(ScummRp::game.features & GF_MACINTOSH))
+		if (_game.id == GID_INDY3 && !(_game.features & GF_MACINTOSH))
 			opcode = 2;
 		else
 			opcode = _getByte();
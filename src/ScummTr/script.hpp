@@ -30,11 +30,14 @@
 #include "common/file.hpp"
 #include "common/toolbox.hpp"
 
+#include "ScummRp/rptypes.hpp"
+
 #include "text.hpp"
 
 #include <list>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 // note: this was enabled in the last official release from 2003, but after
 // some debugging in this area in 2004, it was disabled altogether on 2005-11-22.
@@ -62,11 +65,12 @@ private:
 		int32 length;
 		Text::LineType type;
 		byte opcode;
-		int32 padding;
+		int rscType;
+		int32 rscId;
 
 		StringRef(int32 o, int32 l, Text::LineType t, byte op) :
-			offset(o), length(l), type(t), opcode(op), padding(0) { }
-		StringRef() : offset(0), length(0), type(Text::LT_PLAIN), opcode(0), padding(0) { }
+			offset(o), length(l), type(t), opcode(op), rscType(-1), rscId(-1) { }
+		StringRef() : offset(0), length(0), type(Text::LT_PLAIN), opcode(0), rscType(-1), rscId(-1) { }
 	};
 	struct JumpRef
 	{
@@ -93,13 +97,12 @@ private:
 	static const int MAX_RECURSION = 32;
 
 private:
+	const GameDefinition &_game;
 	FilePartHandle _file;
-	std::list<Script::StringRef> _text;
-	std::list<Script::JumpRef> _jump;
+	std::vector<Script::StringRef> _text;
+	std::vector<Script::JumpRef> _jump;
 	std::list<int32> _spot;
 	bool _log;
-	bool _gettingRscNameLimits;
-	bool _usingRscNameLimits;
 
 public:
 	byte _peekByte();
@@ -111,6 +114,7 @@ public:
 	void _eatArgList();
 	void _eatJump();
 	int32 _eatString(Text::LineType stringType, byte opcode);
+	void _rscName(int rscType, int32 rscId);
 	void _opv12();
 	void _opv345(int r = 0);
 	void _opv67();
@@ -119,6 +123,8 @@ public:
 #ifdef SCUMMTR_CHECK_SCRIPT_JUMPS
 	void _checkJumps();
 #endif // SCUMMTR_CHECK_SCRIPT_JUMPS
+	void _parse();
+	void _setRscNameLimits() const;
 public:
 	void setTrackedSpots(const std::list<int32> &spots);
 	void getTrackedSpots(std::list<int32> &spots) const;
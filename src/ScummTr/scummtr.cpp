@@ -29,6 +29,7 @@
 
 #include "common/backup.hpp"
 #include "common/io.hpp"
+#include "common/stats.hpp"
 #include "common/toolbox.hpp"
 
 #include "scummtr.hpp"
@@ -37,6 +38,8 @@
 #include <cstring>
 
 #include <algorithm>
+#include <iostream>
+#include <stdexcept>
 
 /*
  * ScummTr
@@ -54,19 +57,42 @@ const ScummRp::Parameter ScummTr::_trParameters[] =
 	{ 'p', ScummRp::_paramGameDir, sizeof ScummRp::_paramGameDir, true },
 	{ 'a', ScummTr::_paramPaddedRsc, sizeof ScummTr::_paramPaddedRsc, false },
 	{ 'A', ScummTr::_paramPaddedRsc, sizeof ScummTr::_paramPaddedRsc, false },
+	{ 'M', ScummRp::_paramPageBudget, sizeof ScummRp::_paramPageBudget, false },
+	{ 'R', ScummTr::_paramRooms, sizeof ScummTr::_paramRooms, false },
+	{ 'T', ScummTr::_paramTags, sizeof ScummTr::_paramTags, false },
+	{ 'B', ScummRp::_paramBatch, sizeof ScummRp::_paramBatch, true },
+	{ 'j', ScummRp::_paramJobs, sizeof ScummRp::_paramJobs, false },
 	{ '\0', nullptr, 0, false }
 };
 
 char ScummTr::_paramTextFile[512] = "scummtr.txt";
 char ScummTr::_paramLanguage[3] = "en";
 char ScummTr::_paramPaddedRsc[16] = "";
+char ScummTr::_paramRooms[256] = "";
+char ScummTr::_paramTags[128] = "";
 
 int ScummTr::_textOptions = Text::TXT_NULL;
+std::string *ScummTr::_textBuffer = nullptr;
 int ScummTr::_paddedRsc = 0;
 
 ScummTr::RscNameLimits ScummTr::_rscNameLimits = { { 0, 0, 0 } };
 bool ScummTr::_exportWithPadding = false;
 bool ScummTr::_maxPadding = false;
+std::vector<bool> ScummTr::_selectedRooms;
+std::vector<uint32> ScummTr::_selectedTags;
+bool ScummTr::_serving = false;
+std::map<std::string, ScummTr::WarmGame *> ScummTr::_warmGames;
+
+ScummTr::WarmGame::WarmGame() :
+    fileOptions(0), loaded(false), indexStamp(), tocSet(), files()
+{
+}
+
+ScummTr::WarmGame::~WarmGame()
+{
+	for (std::map<int, ScummTr::WarmFile>::iterator i = files.begin(); i != files.end(); ++i)
+		delete i->second.block;
+}
 
 void ScummTr::_explore(TreeBlock &tree, int action, Text &text)
 {
@@ -75,21 +101,37 @@ void ScummTr::_explore(TreeBlock &tree, int action, Text &text)
 	tree.firstBlock();
 	while ((blockPtr = tree.nextBlock()) != nullptr)
 	{
+		ScummStats::count(ScummStats::CNT_BLOCKS);
+
 		if (blockPtr.is<LFLFPack>() || blockPtr.is<RoomBlock>())
 		{
+			ScummStats::Timer timer(ScummStats::PHS_LFLF);
+			LFLFPack *lflf;
+
+			// see ScummRp::_explore()
+			lflf = (action == ScummRp::ACT_IMPORT) ? dynamic_cast<LFLFPack *>(&*blockPtr) : nullptr;
+			if (lflf != nullptr)
+				lflf->detach();
 			ScummTr::_explore(*blockPtr, action, text);
+			if (lflf != nullptr)
+				lflf->reattach();
 		}
-		else
+		else if (ScummTr::_tagSelected(blockPtr->getTag()))
 		{
 			switch (blockPtr->getTag())
 			{
 			case MKTAG4('L','E','C','F'):
 			case MKTAG2('L','E'):
 				{
-					TreeBlockPtr lecf;
+					LECFPack *lecf;
+					TreeBlockPtr lecfPtr;
+
+					lecfPtr = lecf = new LECFPack(*blockPtr);
 
-					lecf = new LECFPack(*blockPtr);
+					if (!ScummTr::_selectedRooms.empty())
+						lecf->selectRooms(&ScummTr::_selectedRooms);
 					ScummTr::_explore(*lecf, action, text);
+					lecf->saveLOFF();
 				}
 				break;
 			case MKTAG4('S','C','R','P'):
@@ -112,17 +154,13 @@ void ScummTr::_explore(TreeBlock &tree, int action, Text &text)
 					ScriptBlock(*blockPtr).importText(text);
 				else if (action == ScummRp::ACT_EXPORT)
 					ScriptBlock(*blockPtr).exportText(text, ScummTr::_exportWithPadding);
-				else if (action == ScummTr::ACT_RSCNAMELIMITS)
-					ScriptBlock(*blockPtr).getRscNameLimits();
 				break;
 			case MKTAG4('L','S','C','R'):
 			case MKTAG2('L','S'):
 				if (action == ScummRp::ACT_IMPORT)
-					ScriptBlock(*blockPtr, (ScummRp::_game.version == 7) ? 2 : 1).importText(text);
+					ScriptBlock(*blockPtr, (ScummRp::_session->game.version == 7) ? 2 : 1).importText(text);
 				else if (action == ScummRp::ACT_EXPORT)
-					ScriptBlock(*blockPtr, (ScummRp::_game.version == 7) ? 2 : 1).exportText(text, ScummTr::_exportWithPadding);
-				else if (action == ScummTr::ACT_RSCNAMELIMITS)
-					ScriptBlock(*blockPtr, (ScummRp::_game.version == 7) ? 2 : 1).getRscNameLimits();
+					ScriptBlock(*blockPtr, (ScummRp::_session->game.version == 7) ? 2 : 1).exportText(text, ScummTr::_exportWithPadding);
 				break;
 			case MKTAG4('O','B','C','D'):
 				ScummTr::_explore(*blockPtr, action, text);
@@ -132,16 +170,12 @@ void ScummTr::_explore(TreeBlock &tree, int action, Text &text)
 					ObjectNameBlock(*blockPtr).importText(text);
 				else if (action == ScummRp::ACT_EXPORT)
 					ObjectNameBlock(*blockPtr).exportText(text, ScummTr::_exportWithPadding);
-				else if (action == ScummTr::ACT_RSCNAMELIMITS)
-					ObjectNameBlock(*blockPtr).getRscNameLimits();
 				break;
 			case MKTAG4('V','E','R','B'):
 				if (action == ScummRp::ACT_IMPORT)
 					ObjectCodeBlock(*blockPtr).importText(text);
 				else if (action == ScummRp::ACT_EXPORT)
 					ObjectCodeBlock(*blockPtr).exportText(text, ScummTr::_exportWithPadding);
-				else if (action == ScummTr::ACT_RSCNAMELIMITS)
-					ObjectCodeBlock(*blockPtr).getRscNameLimits();
 				break;
 			case MKTAG2('O','C'):
 			case MKTAG4('O','C','v','3'):
@@ -149,8 +183,6 @@ void ScummTr::_explore(TreeBlock &tree, int action, Text &text)
 					OldObjectCodeBlock(*blockPtr).importText(text);
 				else if (action == ScummRp::ACT_EXPORT)
 					OldObjectCodeBlock(*blockPtr).exportText(text, ScummTr::_exportWithPadding);
-				else if (action == ScummTr::ACT_RSCNAMELIMITS)
-					OldObjectCodeBlock(*blockPtr).getRscNameLimits();
 				break;
 			case MKTAG4('O','C','v','2'):
 			case MKTAG4('O','C','v','1'):
@@ -158,8 +190,6 @@ void ScummTr::_explore(TreeBlock &tree, int action, Text &text)
 					OldObjectCodeBlockV1(*blockPtr).importText(text);
 				else if (action == ScummRp::ACT_EXPORT)
 					OldObjectCodeBlockV1(*blockPtr).exportText(text, ScummTr::_exportWithPadding);
-				else if (action == ScummTr::ACT_RSCNAMELIMITS)
-					OldObjectCodeBlockV1(*blockPtr).getRscNameLimits();
 				break;
 			default:
 				break;
@@ -168,6 +198,103 @@ void ScummTr::_explore(TreeBlock &tree, int action, Text &text)
 	}
 }
 
+// Only -S keeps anything between two runs, and only for exports: an import
+// drops everything that was kept, since it's about to change some files
+ScummTr::WarmGame *ScummTr::_warmGame(const std::string &indexPath)
+{
+	std::map<std::string, ScummTr::WarmGame *>::iterator i;
+	std::string key;
+	ScummTr::WarmGame *warm;
+	FileStamp stamp;
+
+	if (!ScummTr::_serving)
+		return nullptr;
+
+	if (ScummRp::_session->options & ScummRp::OPT_IMPORT)
+	{
+		ScummTr::_dropWarmGames();
+		return nullptr;
+	}
+
+	key = std::string(ScummRp::_session->game.shortName) + ':' + indexPath;
+	i = ScummTr::_warmGames.find(key);
+	warm = (i != ScummTr::_warmGames.end()) ? i->second : nullptr;
+	xfilestamp(indexPath.c_str(), stamp);
+
+	if (warm != nullptr && (warm->fileOptions != ScummRp::_session->fileOptions
+	    || warm->indexStamp != stamp))
+	{
+		delete warm;
+		ScummTr::_warmGames.erase(i);
+		warm = nullptr;
+	}
+
+	if (warm == nullptr)
+	{
+		warm = new ScummTr::WarmGame();
+		warm->fileOptions = ScummRp::_session->fileOptions;
+		warm->indexStamp = stamp;
+		ScummTr::_warmGames[key] = warm;
+	}
+
+	return warm;
+}
+
+void ScummTr::_dropWarmGames()
+{
+	for (std::map<std::string, ScummTr::WarmGame *>::iterator i = ScummTr::_warmGames.begin(); i != ScummTr::_warmGames.end(); ++i)
+		delete i->second;
+
+	ScummTr::_warmGames.clear();
+}
+
+void ScummTr::_loadIndex(const std::string &indexPath, TreeBlockPtr &index, ScummTr::WarmGame *warm)
+{
+	if (warm != nullptr && warm->loaded)
+	{
+		ScummRp::_session->mainTocSet = warm->tocSet;
+		return;
+	}
+
+	index = ScummRp::_newIndex(indexPath.c_str());
+	ScummRp::_exploreIndex<ScummRp::ACT_LOAD>(*index);
+	if (warm != nullptr)
+	{
+		warm->tocSet = ScummRp::_session->mainTocSet;
+		warm->loaded = true;
+	}
+}
+
+// The data files kept by -S are reopened only if they were changed
+TreeBlock *ScummTr::_openDataFile(const std::string &path, int id, TreeBlockPtr &own, ScummTr::WarmGame *warm)
+{
+	std::map<int, ScummTr::WarmFile>::iterator i;
+	ScummTr::WarmFile file;
+	bool keep;
+
+	keep = warm != nullptr && xfilestamp(path.c_str(), file.stamp);
+	if (keep && (i = warm->files.find(id)) != warm->files.end())
+	{
+		if (i->second.stamp == file.stamp)
+			return i->second.block;
+
+		delete i->second.block;
+		warm->files.erase(i);
+	}
+
+	if (ScummRp::_session->game.version < 4)
+		file.block = ScummRp::_newLFL(path.c_str(), id);
+	else
+		file.block = new BlocksFile(path.c_str(), ScummRp::_session->fileOptions, ScummRp::_session->backupSystem, id, MKTAG4('D','I','S','K'), ScummRp::_session->game.dataXorKey);
+
+	if (keep)
+		warm->files[id] = file;
+	else
+		own = file.block;
+
+	return file.block;
+}
+
 #ifdef SCUMMTR_HAS_GOOD_GCC_DIAGNOSTIC_PRAGMA_FEATURES
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wformat"
@@ -180,51 +307,59 @@ void ScummTr::_processGameFilesV123()
 	std::string indexPath(ScummRp::_paramGameDir);
 	TreeBlockPtr index;
 	Text::Charset charset;
+	ScummTr::WarmGame *warm;
 
 	charset = ScummTr::_selectCharset();
 	indexPath += '/';
-	indexPath += ScummRp::_game.indexFileName;
-	index = ScummRp::_newIndex(indexPath.c_str());
-	ScummRp::_exploreIndex<ScummRp::ACT_LOAD>(*index);
+	indexPath += ScummRp::_session->game.indexFileName;
+	warm = ScummTr::_warmGame(indexPath);
+	ScummTr::_loadIndex(indexPath, index, warm);
 	{
-		Text text(ScummTr::_paramTextFile, ScummTr::_textOptions, charset);
+		Text text(ScummTr::_paramTextFile, ScummTr::_textOptions, charset, ScummTr::_textBuffer);
 
-		if (ScummRp::_options & ScummRp::OPT_EXPORT)
+		if (ScummRp::_session->options & ScummRp::OPT_EXPORT)
 			text.addExportHeaders();
 
-		if (ScummRp::_options & ScummRp::OPT_IMPORT)
+		if (ScummRp::_session->options & ScummRp::OPT_IMPORT)
+		{
 			text.ensureNoCrlfMisuse();
+			text.selectLines(ScummTr::_lineSelected);
+		}
 
 		for (int i = 1; i < 98; ++i)
 		{
 			std::string dataPath(ScummRp::_paramGameDir);
-			TreeBlockPtr room;
 
-			snprintf(dataFileName, sizeof(dataFileName), ScummRp::_game.dataFileName, i); // ignore -Wformat-security here, ScummRp::_game.dataFileName is internal and safe
+			if (!ScummTr::_roomSelected(i))
+				continue;
+
+			snprintf(dataFileName, sizeof(dataFileName), ScummRp::_session->game.dataFileName, i); // ignore -Wformat-security here, ScummRp::_session->game.dataFileName is internal and safe
 			dataPath += '/';
 			dataPath += dataFileName;
-			if (File::exists(dataPath.c_str()))
+			if (!File::exists(dataPath.c_str()))
+				continue;
+
+			ScummStats::Timer timer(ScummStats::PHS_DISK);
+			TreeBlockPtr own;
+			TreeBlock *room;
+
+			room = ScummTr::_openDataFile(dataPath, i, own, warm);
+			if (ScummRp::_session->options & ScummRp::OPT_IMPORT)
 			{
-				room = ScummRp::_newLFL(dataPath.c_str(), i);
-				if (ScummRp::_options & ScummRp::OPT_IMPORT)
-				{
-					ScummTr::_explore(*room, ScummRp::ACT_IMPORT, text);
-				}
-				else
-				{
-					if (ScummTr::_exportWithPadding)
-					{
-						ScummIO::setQuiet(true);
-						ScummTr::_explore(*room, ScummTr::ACT_RSCNAMELIMITS, text);
-						ScummIO::setQuiet(false);
-					}
-					ScummTr::_explore(*room, ScummRp::ACT_EXPORT, text);
-				}
+				ScummTr::_explore(*room, ScummRp::ACT_IMPORT, text);
+			}
+			else
+			{
+				if (ScummTr::_exportWithPadding)
+					text.deferLines(ScummTr::_rscNamePadding);
+				ScummTr::_explore(*room, ScummRp::ACT_EXPORT, text);
+				text.flushLines();
 			}
 		}
+		text.flush();
 	}
 
-	if (ScummRp::_options & ScummRp::OPT_IMPORT)
+	if (ScummRp::_session->options & ScummRp::OPT_IMPORT)
 	{
 		ScummIO::setQuiet(true);
 		ScummRp::_exploreIndex<ScummRp::ACT_SAVE>(*index);
@@ -239,52 +374,60 @@ void ScummTr::_processGameFilesV4567()
 	TreeBlockPtr index;
 	int numberOfDisks;
 	Text::Charset charset;
+	ScummTr::WarmGame *warm;
 
 	charset = ScummTr::_selectCharset();
 	indexPath += '/';
-	indexPath += ScummRp::_game.indexFileName;
-	index = ScummRp::_newIndex(indexPath.c_str());
-	ScummRp::_exploreIndex<ScummRp::ACT_LOAD>(*index);
-	numberOfDisks = ScummRp::_mainTocSet.roomToc.numberOfDisks();
+	indexPath += ScummRp::_session->game.indexFileName;
+	warm = ScummTr::_warmGame(indexPath);
+	ScummTr::_loadIndex(indexPath, index, warm);
+	numberOfDisks = ScummRp::_session->mainTocSet.roomToc.numberOfDisks();
 	ScummRp::_prepareTmpIndex();
 	{
-		Text text(ScummTr::_paramTextFile, ScummTr::_textOptions, charset);
+		Text text(ScummTr::_paramTextFile, ScummTr::_textOptions, charset, ScummTr::_textBuffer);
 
-		if (ScummRp::_options & ScummRp::OPT_EXPORT)
+		if (ScummRp::_session->options & ScummRp::OPT_EXPORT)
 			text.addExportHeaders();
 
-		if (ScummRp::_options & ScummRp::OPT_IMPORT)
+		if (ScummRp::_session->options & ScummRp::OPT_IMPORT)
+		{
 			text.ensureNoCrlfMisuse();
+			text.selectLines(ScummTr::_lineSelected);
+		}
 
 		for (int i = 1; i < numberOfDisks; ++i)
 		{
 			std::string dataPath(ScummRp::_paramGameDir);
-			TreeBlockPtr disk;
 
-			snprintf(dataFileName, sizeof(dataFileName), ScummRp::_game.dataFileName, i); // ignore -Wformat-security here, ScummRp::_game.dataFileName is internal and safe
+			if (!ScummTr::_diskSelected(i))
+				continue;
+
+			ScummStats::Timer timer(ScummStats::PHS_DISK);
+			TreeBlockPtr own;
+			TreeBlock *disk;
+
+			snprintf(dataFileName, sizeof(dataFileName), ScummRp::_session->game.dataFileName, i); // ignore -Wformat-security here, ScummRp::_session->game.dataFileName is internal and safe
 			dataPath += '/';
 			dataPath += dataFileName;
-			disk = new BlocksFile(dataPath.c_str(), ScummRp::_fileOptions, ScummRp::_backupSystem, i, MKTAG4('D','I','S','K'), ScummRp::_game.dataXorKey);
-			if (ScummRp::_options & ScummRp::OPT_IMPORT)
+			disk = ScummTr::_openDataFile(dataPath, i, own, warm);
+			if (ScummRp::_session->options & ScummRp::OPT_IMPORT)
 			{
 				ScummTr::_explore(*disk, ScummRp::ACT_IMPORT, text);
 			}
 			else
 			{
 				if (ScummTr::_exportWithPadding)
-				{
-					ScummIO::setQuiet(true);
-					ScummTr::_explore(*disk, ScummTr::ACT_RSCNAMELIMITS, text);
-					ScummIO::setQuiet(false);
-				}
+					text.deferLines(ScummTr::_rscNamePadding);
 				ScummTr::_explore(*disk, ScummRp::ACT_EXPORT, text);
+				text.flushLines();
 			}
 			ScummRp::_mergeTmpIndex();
 		}
+		text.flush();
 	}
 	ScummRp::_updateMainIndex();
 
-	if (ScummRp::_options & ScummRp::OPT_IMPORT)
+	if (ScummRp::_session->options & ScummRp::OPT_IMPORT)
 	{
 		ScummIO::setQuiet(true);
 		ScummRp::_exploreIndex<ScummRp::ACT_SAVE>(*index);
@@ -297,7 +440,7 @@ void ScummTr::_processGameFilesV4567()
 
 Text::Charset ScummTr::_selectCharset()
 {
-	if (ScummRp::_game.version > 2)
+	if (ScummRp::_session->game.version > 2)
 		return Text::CHS_V3_WIN1252;
 
 	if (strcmp(ScummTr::_paramLanguage, "en") == 0)
@@ -334,6 +477,11 @@ void ScummTr::setRscNameMaxLengh(ScummTr::RscType t, int32 id, int32 l)
 	}
 }
 
+int32 ScummTr::_rscNamePadding(int rscType, int32 rscId)
+{
+	return ScummTr::getRscNameMaxLengh((ScummTr::RscType)rscType, rscId);
+}
+
 int32 ScummTr::getRscNameMaxLengh(ScummTr::RscType t, int32 id)
 {
 	if (((1 << t) & ScummTr::_paddedRsc) == 0)
@@ -345,16 +493,259 @@ int32 ScummTr::getRscNameMaxLengh(ScummTr::RscType t, int32 id)
 	return ScummTr::_rscNameLimits.rsc[t][id];
 }
 
+// -R takes a list of rooms such as "10-14,20", -T a list of tags such as
+// "SCRP,OBNA" (as shown by -h)
+void ScummTr::_setSelection()
+{
+	const char *p;
+	char *end;
+	long first, last;
+
+	ScummTr::_selectedRooms.clear();
+	if (ScummTr::_paramRooms[0] != '\0')
+	{
+		ScummTr::_selectedRooms.assign(256, false);
+		for (p = ScummTr::_paramRooms; ; p = end + 1)
+		{
+			first = last = std::strtol(p, &end, 10);
+			if (end != p && *end == '-')
+			{
+				p = end + 1;
+				last = std::strtol(p, &end, 10);
+			}
+
+			if (end == p || first < 0 || first > last || last > 255 || (*end != ',' && *end != '\0'))
+				ScummIO::fatal("-R value must be a list of rooms, such as 10-14,20");
+
+			for (long i = first; i <= last; ++i)
+				ScummTr::_selectedRooms[i] = true;
+
+			if (*end == '\0')
+				break;
+		}
+	}
+
+	ScummTr::_selectedTags.clear();
+	if (ScummTr::_paramTags[0] != '\0')
+	{
+		uint32 tag;
+		int len;
+
+		tag = 0;
+		len = 0;
+		for (p = ScummTr::_paramTags; ; ++p)
+		{
+			if (*p == ',' || *p == '\0')
+			{
+				if (len != 2 && len != 4)
+					ScummIO::fatal("-T value must be a list of tags, such as SCRP,OBNA");
+
+				ScummTr::_selectedTags.push_back(ScummTr::_blockTag(tag));
+				tag = 0;
+				len = 0;
+				if (*p == '\0')
+					break;
+			}
+			else
+			{
+				tag = (tag << 8) | (byte)*p;
+				++len;
+			}
+		}
+	}
+
+	// The padding must leave room for the longest name the game may use, and
+	// the other rooms and tags may have longer ones
+	if (ScummTr::_exportWithPadding && (!ScummTr::_selectedRooms.empty() || !ScummTr::_selectedTags.empty()))
+		ScummIO::fatal("-a and -A cannot be used with -R or -T, since the padding depends on the names of the whole game");
+
+	// The lines to import are told apart by their headers: without them, the
+	// lines of a complete export would silently go to the wrong blocks
+	if ((ScummRp::_session->options & ScummRp::OPT_IMPORT) && (!ScummTr::_selectedRooms.empty() || !ScummTr::_selectedTags.empty())
+	    && (!(ScummTr::_textOptions & Text::TXT_HEADER) || (ScummTr::_textOptions & Text::TXT_BINARY)))
+		ScummIO::fatal("-R and -T require -h (and cannot be used with -b) when importing, since the lines to import are found through their headers");
+}
+
+bool ScummTr::_roomSelected(int roomId)
+{
+	if (ScummTr::_selectedRooms.empty())
+		return true;
+
+	return roomId >= 0 && roomId < (int)ScummTr::_selectedRooms.size() && ScummTr::_selectedRooms[roomId];
+}
+
+bool ScummTr::_diskSelected(int diskId)
+{
+	const GlobalRoomIndex &roomToc = ScummRp::_session->mainTocSet.roomToc;
+
+	if (ScummTr::_selectedRooms.empty())
+		return true;
+
+	for (int i = 0; i < roomToc.getSize(); ++i)
+		if (ScummTr::_roomSelected(i) && roomToc[i].roomId == diskId)
+			return true;
+
+	return false;
+}
+
+bool ScummTr::_tagSelected(uint32 tag)
+{
+	if (ScummTr::_selectedTags.empty())
+		return true;
+
+	switch (tag)
+	{
+	case MKTAG4('L','E','C','F'):
+	case MKTAG2('L','E'):
+	case MKTAG4('O','B','C','D'):
+		return true;
+	default:
+		break;
+	}
+
+	tag = ScummTr::_blockTag(tag);
+	for (size_t i = 0; i < ScummTr::_selectedTags.size(); ++i)
+		if (ScummTr::_selectedTags[i] == tag)
+			return true;
+
+	return false;
+}
+
+// The names of old objects are exported with an ON tag, from OC blocks
+uint32 ScummTr::_blockTag(uint32 tag)
+{
+	if (tag == MKTAG2('O','N'))
+		return MKTAG2('O','C');
+
+	if ((tag & 0xFFFF0000) == MKTAG4('O','N','\0','\0'))
+		return (tag & 0x0000FFFF) | MKTAG4('O','C','\0','\0');
+
+	return tag;
+}
+
+bool ScummTr::_lineSelected(int lflfId, uint32 tag)
+{
+	return ScummTr::_roomSelected(lflfId) && ScummTr::_tagSelected(tag);
+}
+
+void ScummTr::_reset()
+{
+	ScummRp::_reset();
+
+	std::strcpy(ScummTr::_paramTextFile, "scummtr.txt");
+	std::strcpy(ScummTr::_paramLanguage, "en");
+	std::strcpy(ScummTr::_paramPaddedRsc, "");
+	std::strcpy(ScummTr::_paramRooms, "");
+	std::strcpy(ScummTr::_paramTags, "");
+	ScummTr::_selectedRooms.clear();
+	ScummTr::_selectedTags.clear();
+	ScummTr::_textOptions = Text::TXT_NULL;
+	ScummTr::_paddedRsc = 0;
+	ScummTr::_exportWithPadding = false;
+	ScummTr::_maxPadding = false;
+	for (int i = 0; i < 3; ++i)
+	{
+		ScummTr::_rscNameLimits.anyRsc[i] = 0;
+		ScummTr::_rscNameLimits.rsc[i].clear();
+	}
+}
+
+// See ScummRp::run()
+int ScummTr::run(int argc, const char **argv)
+{
+	return ScummTr::_runWithText(argc, argv, nullptr);
+}
+
+// Same as run(), but the text is exported to this buffer, or imported from
+// it, instead of the -f file
+int ScummTr::run(int argc, const char **argv, std::string &text)
+{
+	return ScummTr::_runWithText(argc, argv, &text);
+}
+
+int ScummTr::_runWithText(int argc, const char **argv, std::string *text)
+{
+	std::string *previous;
+	int r;
+
+	previous = ScummTr::_textBuffer;
+	ScummTr::_textBuffer = text;
+	try
+	{
+		r = ScummRp::_run(ScummTr::main, ScummTr::_reset, argc, argv);
+	}
+	catch (...)
+	{
+		ScummTr::_textBuffer = previous;
+		throw;
+	}
+	ScummTr::_textBuffer = previous;
+
+	return r;
+}
+
+// Handle requests from the standard input, one per line, with the same
+// arguments as the command line. The output of each request is followed by
+// an "@OK" or "@ERROR <message>" line. This saves the start-up cost of a
+// new process for each request, and exports of a game already seen reuse its
+// tables of contents and data files, as long as they weren't changed since.
+int ScummTr::_serve()
+{
+	std::string line;
+	std::vector<std::string> args;
+	std::vector<const char *> argv;
+	int ret;
+
+	if (ScummTr::_serving)
+		throw std::runtime_error("Cannot serve requests from a request");
+
+	ScummTr::_serving = true;
+	while (std::getline(std::cin, line))
+	{
+		ScummRp::_splitArgs(line, args);
+		if (args.empty())
+			continue;
+
+		argv.assign(1, ScummTr::NAME);
+		for (size_t i = 0; i < args.size(); ++i)
+			argv.push_back(args[i].c_str());
+
+		try
+		{
+			ret = ScummTr::run((int)argv.size(), &argv[0]);
+			if (ret == 0)
+				std::cout << "@OK" << std::endl;
+			else
+				std::cout << "@ERROR " << xsprintf("Exit status %i", ret) << std::endl;
+		}
+		catch (std::exception &e)
+		{
+			ScummTr::_dropWarmGames();
+			std::cout << "@ERROR " << e.what() << std::endl;
+		}
+	}
+	ScummTr::_dropWarmGames();
+	ScummTr::_serving = false;
+
+	return 0;
+}
+
 int ScummTr::main(int argc, const char **argv)
 {
 	int g;
 
 	ScummTr::_getOptions(argc, argv, ScummTr::_trParameters);
-	ScummIO::setInfoSlots(ScummRp::_infoSlots);
+	ScummIO::setInfoSlots(ScummRp::_session->infoSlots);
 	ScummIO::info(INF_GLOBAL, xsprintf("%s %s (build %s) by %s", ScummTr::NAME, ScummTr::VERSION, SCUMMTR_BUILD_DATE, ScummTr::AUTHOR));
 	ScummIO::info(INF_GLOBAL, "");
 
-	if (ScummRp::_options & ScummRp::OPT_LIST)
+	if (ScummRp::_session->options & ScummRp::OPT_SERVE)
+		return ScummTr::_serve();
+
+	if (ScummRp::_session->options & ScummRp::OPT_BATCH)
+		return ScummRp::_batch(ScummTr::NAME, ScummTr::run, ScummTr::_trParameters);
+
+	if (ScummRp::_session->options & ScummRp::OPT_LIST)
 	{
 		ScummTr::_listGames();
 		return 0;
@@ -393,36 +784,39 @@ int ScummTr::main(int argc, const char **argv)
 		return 0;
 	}
 
-	ScummRp::_game = ScummRp::_gameDef[g];
+	ScummRp::_session->game = ScummRp::_gameDef[g];
+	ScummRp::_setPageBudget();
+	ScummTr::_setSelection();
 
 #ifndef SCUMMRP_OK_TO_CORRUPT_MANIACV2
-	if (ScummRp::_game.version == 2 && ScummRp::_game.id == GID_MANIAC && ScummRp::_options & ScummRp::OPT_IMPORT)
+	if (ScummRp::_session->game.version == 2 && ScummRp::_session->game.id == GID_MANIAC && ScummRp::_session->options & ScummRp::OPT_IMPORT)
 		ScummIO::fatal("Modifying Maniac Mansion V2 is known to corrupt it");
 #endif
 
 	// FIXME: <https://github.com/dwatteau/scummtr/issues/47>
-	if (ScummRp::_game.version == 4 && ScummRp::_game.id == GID_MONKEY && ScummRp::_options & ScummRp::OPT_IMPORT)
+	if (ScummRp::_session->game.version == 4 && ScummRp::_session->game.id == GID_MONKEY && ScummRp::_session->options & ScummRp::OPT_IMPORT)
 		ScummIO::warning("ScummVM may incorrectly display the floppy versions of Monkey1 when modifying them\nTest them with DREAMM/DOSBox instead, or add a ScummVM MD5 detection entry for them (bug #47)");
 
-	if (ScummRp::_options & ScummRp::OPT_IMPORT)
+	if (ScummRp::_session->options & ScummRp::OPT_IMPORT)
 	{
-		ScummRp::_fileOptions |= BlocksFile::BFOPT_BACKUP;
+		ScummRp::_session->fileOptions |= BlocksFile::BFOPT_BACKUP;
 	}
 	else
 	{
-		ScummRp::_fileOptions |= BlocksFile::BFOPT_READONLY;
+		ScummRp::_session->fileOptions |= BlocksFile::BFOPT_READONLY;
 		ScummTr::_textOptions |= Text::TXT_OUT;
 	}
 
 	if (ScummTr::_textOptions & Text::TXT_BINARY)
 		ScummIO::warning("the -b option doesn't work reliably with all games");
 
-	if (ScummRp::_game.version < 4)
+	if (ScummRp::_session->game.version < 4)
 		ScummTr::_processGameFilesV123();
 	else
 		ScummTr::_processGameFilesV4567();
 
-	ScummRp::_backupSystem.applyChanges();
+	ScummRp::_session->backupSystem.applyChanges();
+	ScummStats::report(ScummTr::NAME);
 
 	return 0;
 }
@@ -431,6 +825,9 @@ bool ScummTr::_readOption(const char *arg, char *pendingParams)
 {
 	char c;
 
+	if (ScummRp::_readStatsOption(arg))
+		return true;
+
 	if (arg[0] != '-')
 		return true;
 
@@ -469,47 +866,61 @@ bool ScummTr::_readOption(const char *arg, char *pendingParams)
 			ScummTr::_textOptions |= Text::TXT_BINARY;
 			break;
 		case 'o':
-			ScummRp::_options |= ScummRp::OPT_EXPORT;
+			ScummRp::_session->options |= ScummRp::OPT_EXPORT;
 			break;
 		case 'i':
-			ScummRp::_options |= ScummRp::OPT_IMPORT;
+			ScummRp::_session->options |= ScummRp::OPT_IMPORT;
 			break;
 		case 's':
-			ScummRp::_fileOptions = BlocksFile::BFOPT_NULL;
+			ScummRp::_session->fileOptions = BlocksFile::BFOPT_NULL;
 			break;
 		case 'm':
-			ScummRp::_fileOptions &= ~BlocksFile::BFOPT_AUTO;
-			ScummRp::_fileOptions |= BlocksFile::BFOPT_RAM;
+			ScummRp::_session->fileOptions &= ~BlocksFile::BFOPT_AUTO;
+			ScummRp::_session->fileOptions |= BlocksFile::BFOPT_RAM;
+			break;
+		case 'M':
+			ScummRp::_session->fileOptions |= BlocksFile::BFOPT_PAGED;
+			ScummRp::_queueParam(pendingParams, c);
 			break;
 		case 'n':
 			ScummTr::_textOptions |= Text::TXT_NO_COMMENT;
 			break;
 		case 'O':
-			ScummRp::_fileOptions &= ~BlocksFile::BFOPT_AUTO;
-			ScummRp::_fileOptions |= BlocksFile::BFOPT_SEQFILE;
+			ScummRp::_session->fileOptions &= ~BlocksFile::BFOPT_AUTO;
+			ScummRp::_session->fileOptions |= BlocksFile::BFOPT_SEQFILE;
 			break;
 		case 'L':
-			ScummRp::_options |= ScummRp::OPT_LIST;
+			ScummRp::_session->options |= ScummRp::OPT_LIST;
+			return false;
+		case 'S':
+			ScummRp::_session->options |= ScummRp::OPT_SERVE;
 			return false;
+		case 'B':
+			ScummRp::_session->options |= ScummRp::OPT_BATCH;
+			ScummRp::_queueParam(pendingParams, c);
+			break;
 		case 'q':
-			ScummRp::_infoSlots = INF_NULL; // intentionally not definitive
+			ScummRp::_session->infoSlots = INF_NULL; // intentionally not definitive
 			break;
 		case 'r':
 			ScummTr::_textOptions |= Text::TXT_RAW;
 			break;
 		case 'v':
-			ScummRp::_infoSlots |= INF_DETAIL;
+			ScummRp::_session->infoSlots |= INF_DETAIL;
 			break;
 // 		case 'V':
-// 			ScummRp::_infoSlots |= INF_LISTING;
+// 			ScummRp::_session->infoSlots |= INF_LISTING;
 // 			break;
 		case 'g':
-			ScummRp::_options |= ScummRp::OPT_GAME_FILES;
+			ScummRp::_session->options |= ScummRp::OPT_GAME_FILES;
 			ScummRp::_queueParam(pendingParams, c);
 			break;
 		case 'l':
 		case 'p':
 		case 'f':
+		case 'R':
+		case 'T':
+		case 'j':
 			ScummRp::_queueParam(pendingParams, c);
 			break;
 		default:
@@ -561,11 +972,11 @@ bool ScummTr::_invalidOptions()
 	static const uint32 mandatory[] = { ScummRp::OPT_IMPORT | ScummRp::OPT_EXPORT, ScummRp::OPT_GAME_FILES, 0 };
 
 	for (int i = 0; mandatory[i] != 0; ++i)
-		if (!(ScummRp::_options & mandatory[i]))
+		if (!(ScummRp::_session->options & mandatory[i]))
 			return true;
 
 	for (int i = 0; exclusive[i] != 0; ++i)
-		if ((ScummRp::_options & exclusive[i]) == exclusive[i])
+		if ((ScummRp::_session->options & exclusive[i]) == exclusive[i])
 			return true;
 
 	return false;
@@ -576,7 +987,10 @@ void ScummTr::_usage()
 	std::cout << "options:\n\n";
 	std::cout << " -i         " << "import text into the game files (input)\n";
 	std::cout << " -o         " << "export text from the game files (output)\n";
-	std::cout << " -L         " << "list supported games\n\n";
+	std::cout << " -L         " << "list supported games\n";
+	std::cout << " -B path    " << "run all the scummtr jobs listed in this manifest file\n";
+	std::cout << " -j jobs    " << "with -B, run at most this many jobs at once (default: one per CPU)\n";
+	std::cout << " -S         " << "run the requests read from the standard input\n\n";
 	std::cout << " -a [aov]   " << "protect actors/objects/verbs for safer renames\n";
 	std::cout << " -A [aov]   " << "same as -a, but with extra safety\n";
 	std::cout << " -b         " << "binary mode (may not work with all games)\n";
@@ -588,15 +1002,19 @@ void ScummTr::_usage()
 	std::cout << " -I         " << "include SCUMM instruction opcode before each line\n";
 	std::cout << " -l xx      " << "language for -c (V1/V2 games only): en, de, it, fr\n";
 // 	std::cout << " -m         " << "work in memory (whole game files are loaded in RAM)\n";
+	std::cout << " -M size    " << "work in memory, with at most this many MB per game file\n";
 	std::cout << " -n         " << "never output any \"ScummTR note\" comment\n";
 // 	std::cout << " -O         " << "optimize for sequential access (with -i)\n";
 	std::cout << " -p path    " << "path to the game (default: current directory)\n";
 	std::cout << " -q         " << "quiet mode\n";
 	std::cout << " -r         " << "raw text (preserve original text encoding)\n";
+	std::cout << " -R rooms   " << "only export/import text from these rooms (e.g. 10-14,20)\n";
 // 	std::cout << " -s         " << "slow mode (disable automatic -m or -O)\n";
+	std::cout << " -T tags    " << "only export/import text from blocks with these tags (e.g. SCRP,OBNA)\n";
 	std::cout << " -v         " << "verbose mode\n";
 // 	std::cout << " -V         " << "more verbose (lists blocks)\n";
-	std::cout << " -w         " << "use Windows CRLF newline characters\n\n";
+	std::cout << " -w         " << "use Windows CRLF newline characters\n";
+	std::cout << " --stats    " << "print timings and counters once done (--stats=json for JSON)\n\n";
 
 	std::cout << "Examples:\n";
 	std::cout << "scummtr -g zakv2    -l de -c -wh -A aov -of zak_v2_de.txt\n";
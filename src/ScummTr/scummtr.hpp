@@ -33,6 +33,8 @@
 
 #include "text.hpp"
 
+#include <map>
+#include <string>
 #include <vector>
 
 // TODO make it instanciable (though it's not needed yet)
@@ -40,10 +42,6 @@
 class ScummTr : public ScummRp
 {
 public:
-	enum
-	{
-		ACT_RSCNAMELIMITS = 0x100
-	};
 	enum RscType
 	{
 		RSCT_ACTOR = 0,
@@ -66,7 +64,10 @@ protected:
 	static char _paramLanguage[3];
 	static char _paramTextFile[512];
 	static char _paramPaddedRsc[16];
+	static char _paramRooms[256];
+	static char _paramTags[128];
 	static int _textOptions;
+	static std::string *_textBuffer;
 	static int _paddedRsc;
 	static struct RscNameLimits
 	{
@@ -75,21 +76,67 @@ protected:
 	} _rscNameLimits;
 	static bool _exportWithPadding;
 	static bool _maxPadding;
+	static std::vector<bool> _selectedRooms;
+	static std::vector<uint32> _selectedTags;
+	// What -S keeps from one export to the next on the same game: the tables
+	// of contents from the index, and the data files, left open. Each of them
+	// is dropped as soon as its file is seen changed, and all of them as soon
+	// as an import is requested.
+	struct WarmFile
+	{
+		TreeBlock *block;
+		FileStamp stamp;
+	};
+	struct WarmGame
+	{
+	public:
+		int fileOptions;
+		bool loaded;
+		FileStamp indexStamp;
+		ScummRp::TOCSet tocSet;
+		std::map<int, ScummTr::WarmFile> files;
+
+	public:
+		WarmGame();
+		~WarmGame();
+
+	private: // Not copiable
+		WarmGame(const WarmGame &);
+		WarmGame &operator=(const WarmGame &);
+	};
+	static bool _serving;
+	static std::map<std::string, ScummTr::WarmGame *> _warmGames;
 
 protected:
 	static bool _readOption(const char *arg, char *pendingParams);
 	static void _getOptions(int argc, const char **argv, const ScummRp::Parameter *params);
 	static bool _invalidOptions();
 	static void _usage();
+	static int _runWithText(int argc, const char **argv, std::string *text);
 	static void _explore(TreeBlock &tree, int action, Text &text);
 	static void _processGameFilesV123();
 	static void _processGameFilesV4567();
 	static Text::Charset _selectCharset();
+	static ScummTr::WarmGame *_warmGame(const std::string &indexPath);
+	static void _dropWarmGames();
+	static void _loadIndex(const std::string &indexPath, TreeBlockPtr &index, ScummTr::WarmGame *warm);
+	static TreeBlock *_openDataFile(const std::string &path, int id, TreeBlockPtr &own, ScummTr::WarmGame *warm);
+	static int32 _rscNamePadding(int rscType, int32 rscId);
+	static void _setSelection();
+	static bool _roomSelected(int roomId);
+	static bool _diskSelected(int diskId);
+	static bool _tagSelected(uint32 tag);
+	static uint32 _blockTag(uint32 tag);
+	static bool _lineSelected(int lflfId, uint32 tag);
+	static void _reset();
+	static int _serve();
 
 public:
 	static void setRscNameMaxLengh(ScummTr::RscType t, int32 id, int32 l);
 	static int32 getRscNameMaxLengh(ScummTr::RscType t, int32 id);
 	static int main(int argc, const char **argv);
+	static int run(int argc, const char **argv);
+	static int run(int argc, const char **argv, std::string &text);
 
 private:
 	ScummTr();
@@ -26,11 +26,14 @@
 
 #include "common/toolbox.hpp"
 #include "common/io.hpp"
+#include "common/stats.hpp"
 #include "ScummRp/block.hpp" // for tagToStr
 #include "ScummRp/scummrp.hpp"
 
 #include "text.hpp"
 
+#include <cstring>
+
 const char Text::CT_NULL[256] =
 {
 	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -181,28 +184,56 @@ const char *const Text::CHARSETS[] =
 	Text::CT_V1FR
 };
 
-Text::Text(const char *path, int flags, Text::Charset charset) :
-    _file(path, (flags & Text::TXT_OUT) != 0 ? (std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc) : (std::ios::in | std::ios::binary)),
+// With a buffer, the text is read from it (or written to it) instead of the
+// file at path, which is then only used in messages
+Text::Text(const char *path, int flags, Text::Charset charset, std::string *buffer) :
+    _diskFile(), _memFile(), _file(buffer != nullptr ? (File &)_memFile : _diskFile), _buffer(buffer),
     _cur(0), _lineCount(0), _lflfId(-1), _tag(0), _id(-1),
     _binary((flags & Text::TXT_BINARY) != 0), _comments((flags & Text::TXT_NO_COMMENT) == 0),
     _handleCrlfFlag((flags & Text::TXT_CRLF) != 0),
     _header((flags & Text::TXT_HEADER) != 0), _hex((flags & Text::TXT_HEXA) != 0),
     _opcode((flags & Text::TXT_OPCODE) != 0),
     _rawText((flags & Text::TXT_RAW) != 0),
-    _charset(Text::CHARSETS[(flags & Text::TXT_CHARSET1252) != 0 ? (int)charset : (int)Text::CHS_NULL])
+    _charset(Text::CHARSETS[(flags & Text::TXT_CHARSET1252) != 0 ? (int)charset : (int)Text::CHS_NULL]),
+    _lineHeader(), _out(), _padding(nullptr), _select(nullptr), _pending()
 {
-	if (!_file.is_open())
-		throw File::IOError(xsprintf("Cannot open %s", path));
+	if (_buffer == nullptr)
+	{
+		_diskFile.open(path, (flags & Text::TXT_OUT) != 0 ? (std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc) : (std::ios::in | std::ios::binary));
+		if (!_diskFile.is_open())
+			throw File::IOError(xsprintf("Cannot open %s", path));
+	}
+	else if (flags & Text::TXT_OUT)
+	{
+		_buffer->resize(0);
+	}
+	else
+	{
+		_memFile.openMemory(path, *_buffer);
+	}
 
 	for (int i = 0; i < 256; ++i)
 		_finalCharset[i] = (char)(byte)i;
 
 	for (int i = 0; i < 256; ++i)
 		_finalCharset[(byte)_charset[i]] = (char)(byte)i;
+
+	_initEscTables();
+
+	if (flags & Text::TXT_OUT)
+		_out.reserve(Text::OUTPUT_BUFFER_SIZE + 0x1000);
 }
 
 Text::~Text()
 {
+	try
+	{
+		_flushOutput();
+	}
+	catch (std::exception &e)
+	{
+		ScummIO::majorIssue(e.what());
+	}
 }
 
 void Text::setInfo(int lflfId, uint32 tag, int id)
@@ -210,11 +241,14 @@ void Text::setInfo(int lflfId, uint32 tag, int id)
 	_lflfId = lflfId;
 	_tag = tag;
 	_id = id;
+
+	if (_header)
+		_lineHeader = info();
 }
 
 const char *Text::info() const
 {
-	return xsprintf("[%.3i:%s#%.4i]", _lflfId, Block::tagToStr(_tag), _id);
+	return xsprintf("[%.3i:%s#%.4i]", _lflfId, Block::tagToStr(_tag).c_str(), _id);
 }
 
 const char *Text::internalCommentHeader() const
@@ -263,51 +297,46 @@ int Text::funcLen(byte c)
 	}
 }
 
-void Text::_writeChar(byte b)
+// Every byte of the game is written either as itself (through the charset),
+// or as an escape sequence; both forms are computed once here
+void Text::_initEscTables()
 {
+	static const char hexDigits[] = "0123456789ABCDEF";
 	char c;
 
-	c = (_rawText) ? (char)b : _charset[b];
-
-	if ((!_rawText && c == '\0') || (_rawText && b < 0x20))
-		_writeEscChar(b);
-	else if (c == '\\')
-		_file.write("\\\\", 2);
-	else
-		_file.write(&c, 1);
-}
-
-void Text::_writeEscChar(byte b)
-{
-	char c;
-
-	if (_hex)
-	{
-		_file.write("\\x", 2);
-		c = (char)(b / 16) + '0';
-		if (c > '9')
-			c += 'A' - '9' - 1;
-		_file.write(&c, 1);
-
-		b %= 16;
-		c = (char)b + '0';
-		if (c > '9')
-			c += 'A' - '9' - 1;
-		_file.write(&c, 1);
-	}
-	else
+	for (int i = 0; i < 256; ++i)
 	{
-		_file.write("\\", 1);
-		c = (char)(b / 100) + '0';
-		_file.write(&c, 1);
+		char *e = _funcEsc[i];
 
-		b %= 100;
-		c = (char)(b / 10) + '0';
-		_file.write(&c, 1);
+		e[0] = '\\';
+		if (_hex)
+		{
+			e[1] = 'x';
+			e[2] = hexDigits[i / 16];
+			e[3] = hexDigits[i % 16];
+		}
+		else
+		{
+			e[1] = (char)('0' + i / 100);
+			e[2] = (char)('0' + i / 10 % 10);
+			e[3] = (char)('0' + i % 10);
+		}
+		e[4] = '\0';
 
-		b %= 10;
-		c = (char)b + '0';
-		_file.write(&c, 1);
+		c = (_rawText) ? (char)i : _charset[i];
+		if ((!_rawText && c == '\0') || (_rawText && i < 0x20))
+		{
+			memcpy(_charEsc[i], _funcEsc[i], sizeof _charEsc[i]);
+		}
+		else if (c == '\\')
+		{
+			strcpy(_charEsc[i], "\\\\");
+		}
+		else
+		{
+			_charEsc[i][0] = c;
+			_charEsc[i][1] = '\0';
+		}
 	}
 }
 
@@ -336,7 +365,7 @@ void Text::_writeEscRsc(const std::string &s)
 		}
 		else if (b == 0xFF)
 		{
-			if (ScummRp::game.id == GID_INDY3 && i < size - 1)
+			if (ScummRp::game().id == GID_INDY3 && i < size - 1)
 			{
 				byte nextByte = (byte)s[i + 1];
 				if (nextByte == 0x20)
@@ -416,7 +445,7 @@ void Text::_writeEscMsg(const std::string &s)
 			// This is a bug in the original and official German releases of the game.
 			// See issue #58, https://bugs.scummvm.org/ticket/1675, and
 			// https://bugs.scummvm.org/ticket/2715.
-			if (ScummRp::game.id == GID_INDY3 && b == 0xFF && i < size - 1)
+			if (ScummRp::game().id == GID_INDY3 && b == 0xFF && i < size - 1)
 			{
 				byte nextByte = (byte)s[i + 1];
 				if (nextByte == 0x2E || nextByte == 0x20)
@@ -456,9 +485,9 @@ void Text::_writeEsc(const std::string &s, Text::LineType t)
 	}
 
 	if (_handleCrlfFlag)
-		_file.write("\r\n", 2);
+		_out += "\r\n";
 	else
-		_file.write("\n", 1);
+		_out += '\n';
 }
 
 void Text::_checkMsg(const std::string &s, int l)
@@ -556,10 +585,24 @@ void Text::_unEsc(std::string &s, Text::LineType t) const
 	{
 		if (s[i] != '\\')
 		{
+			const char *esc;
+			size_t end;
+
+			// whole run up to the next escape sequence
+			esc = (const char *)memchr(s.data() + i, '\\', size - i);
+			end = (esc != nullptr) ? (size_t)(esc - s.data()) : size;
 			if (_rawText)
-				s[j++] = (char)(byte)s[i];
+			{
+				if (j != i)
+					memmove(&s[j], &s[i], end - i);
+				j += end - i;
+			}
 			else
-				s[j++] = _finalCharset[(byte)s[i]];
+			{
+				for (; i < end; ++i)
+					s[j++] = _finalCharset[(byte)s[i]];
+			}
+			i = end - 1;
 		}
 		else
 		{
@@ -645,75 +688,161 @@ int Text::getLineLength(FileHandle &f, Text::LineType t)
 	throw std::logic_error("Text::getLineLength: Wrong type");
 }
 
-int Text::getLengthRsc(FileHandle &f)
+// The _span*() functions look for the end of a string in p[0..n), starting
+// from p[i] (which is always at the start of a character or a function).
+// They return the size of the string with its terminator, -1 if more data
+// is needed (and then i tells where to resume), or -2 if the string is
+// truncated by the end of the file.
+
+int32 Text::_spanRsc(const byte *p, int32 n, int32 &i, bool atEnd)
 {
-	byte b;
-	int32 start;
+	int32 next;
 
-	start = f->tellg(std::ios::beg);
-	while (!f->eof() && f->getByte(b) != 0)
+	while (i < n)
 	{
-		if (b == 0xFF)
-			f->seekg(3, std::ios::cur);
-		else if (b == 0xFE)
-			f->seekg(1, std::ios::cur);
+		if (p[i] == 0)
+			return i + 1;
+
+		if (p[i] == 0xFF)
+			next = i + 4;
+		else if (p[i] == 0xFE)
+			next = i + 2;
+		else
+			next = i + 1;
+
+		if (next > n)
+			return atEnd ? -2 : -1;
+		i = next;
 	}
 
-	return f->tellg(std::ios::beg) - start - 1;
+	return atEnd ? n : -1;
 }
 
-int Text::getLengthOldMsg(FileHandle &f)
+int32 Text::_spanOldMsg(const byte *p, int32 n, int32 &i, bool atEnd)
 {
-	byte b;
-	int32 start;
+	int32 next;
 
-	start = f->tellg(std::ios::beg);
-	while (!f->eof() && f->getByte(b) != 0)
-		if (b < 8 && b > 3)
-			f->getByte(b);
+	while (i < n)
+	{
+		if (p[i] == 0)
+			return i + 1;
 
-	return f->tellg(std::ios::beg) - start - 1;
+		next = (p[i] < 8 && p[i] > 3) ? i + 2 : i + 1;
+		if (next > n)
+			return atEnd ? -2 : -1;
+		i = next;
+	}
+
+	return atEnd ? n : -1;
 }
 
-int Text::getLengthMsg(FileHandle &f)
+int32 Text::_spanMsg(const byte *p, int32 n, int32 &i, bool atEnd)
 {
 	byte b, nextByte;
-	int32 start;
-	int i;
+	int32 next;
 
-	start = f->tellg(std::ios::beg);
-	while (!f->eof() && f->getByte(b) != 0)
+	while (i < n)
 	{
+		b = p[i];
+		if (b == 0)
+			return i + 1;
+
 		if (b == 0xFF || b == 0xFE)
 		{
-			f->getByte(nextByte);
+			if (i + 1 >= n)
+				return atEnd ? -2 : -1;
+
+			nextByte = p[i + 1];
 
 			// Ignore badly encoded German Eszett characters that would be interpreted
 			// as a \255 escape sequence. See also Text::_writeEscMsg() comment above.
-			if (ScummRp::game.id == GID_INDY3 && b == 0xFF && (nextByte == 0x2E || nextByte == 0x20))
+			if (ScummRp::game().id == GID_INDY3 && b == 0xFF && (nextByte == 0x2E || nextByte == 0x20))
 			{
 				ScummIO::info(INF_DETAIL, xsprintf("Ignoring 0x%.2X%.2X sequence in Indy3 (likely a bogus German Eszett)", b, nextByte));
+				i += 2;
 				continue;
 			}
 
-			i = Text::funcLen(nextByte);
-			f->seekg(i, std::ios::cur);
+			next = i + 2 + Text::funcLen(nextByte);
+		}
+		else
+		{
+			next = i + 1;
 		}
+
+		if (next > n)
+			return atEnd ? -2 : -1;
+		i = next;
 	}
 
-	return f->tellg(std::ios::beg) - start - 1;
+	return atEnd ? n : -1;
 }
 
-int Text::getLengthPlain(FileHandle &f)
+int32 Text::_spanPlain(const byte *p, int32 n, int32 &i, bool atEnd)
 {
-	byte b;
-	int32 start;
+	const void *z;
+
+	z = memchr(p + i, 0, n - i);
+	if (z != nullptr)
+		return (int32)((const byte *)z - p) + 1;
+
+	i = n;
+	return atEnd ? n : -1;
+}
+
+// Reads the string in growing chunks rather than byte per byte, and leaves
+// the file just after it
+int Text::_getLength(FileHandle &f, Text::SpanFunc span)
+{
+	std::string buffer;
+	int32 start, avail, chunk, n, i, r;
 
 	start = f->tellg(std::ios::beg);
-	while (!f->eof() && f->getByte(b) != 0)
-		;
+	avail = f->size() - start;
+	chunk = 0x100;
+	i = 0;
+	do
+	{
+		n = (int32)buffer.size();
+		if (chunk > avail - n)
+			chunk = avail - n;
+
+		if (chunk > 0)
+		{
+			buffer.resize(n + chunk);
+			f->read(&buffer[n], chunk);
+		}
+
+		r = span((const byte *)buffer.data(), (int32)buffer.size(), i, (int32)buffer.size() == avail);
+		chunk = (int32)buffer.size() * 2;
+	} while (r == -1);
+
+	if (r == -2)
+		throw File::UnexpectedEOF(xsprintf("Unexpected EOF in: %s <0x%X, 0x%X>", f->name().c_str(), (int)f->fullOffset(), (int)f->size()));
+
+	f->seekg(start + r, std::ios::beg);
+
+	return r - 1;
+}
 
-	return f->tellg(std::ios::beg) - start - 1;
+int Text::getLengthRsc(FileHandle &f)
+{
+	return Text::_getLength(f, Text::_spanRsc);
+}
+
+int Text::getLengthOldMsg(FileHandle &f)
+{
+	return Text::_getLength(f, Text::_spanOldMsg);
+}
+
+int Text::getLengthMsg(FileHandle &f)
+{
+	return Text::_getLength(f, Text::_spanMsg);
+}
+
+int Text::getLengthPlain(FileHandle &f)
+{
+	return Text::_getLength(f, Text::_spanPlain);
 }
 
 void Text::_getBinaryLine(std::string &s, Text::LineType lineType)
@@ -885,29 +1014,57 @@ void Text::ensureNoCrlfMisuse()
 
 bool Text::nextLine(std::string &s, Text::LineType lineType)
 {
-	if (_cur >= _file.size())
-	{
-		s.resize(0);
+	ScummStats::Timer timer(ScummStats::PHS_TEXT_IO);
+
+	if (!_nextLine(s, lineType))
 		return false;
-	}
 
-	_file.seekg(_cur, std::ios::beg);
-	if (_binary)
-	{
-		_getBinaryLine(s, lineType);
-	}
-	else
+	ScummStats::count(ScummStats::CNT_LINES_IMPORTED);
+	return true;
+}
+
+// Ignore lines starting with an internal comment, and the lines of the blocks
+// which weren't selected, when importing a part of a complete export
+bool Text::_skippedLine(const std::string &s) const
+{
+	int lflfId;
+	uint32 tag;
+
+	if (s.find(";; ScummTR note: ", 0) == 0)
+		return true;
+
+	return _header && _select != nullptr && Text::_parseHeader(s, lflfId, tag) && !_select(lflfId, tag);
+}
+
+bool Text::_nextLine(std::string &s, Text::LineType lineType)
+{
+	// skipped lines are read in a loop, since a partial import can skip tens
+	// of thousands of them in a row
+	for (;;)
 	{
-		_file.getline(s, '\n');
+		if (_cur >= _file.size())
+		{
+			s.resize(0);
+			return false;
+		}
 
-		// Ignore lines starting with an internal comment
-		if (s.find(";; ScummTR note: ", 0) == 0)
+		_file.seekg(_cur, std::ios::beg);
+		if (_binary)
 		{
-			++_lineCount;
-			_cur = _file.tellg(std::ios::beg);
-			return Text::nextLine(s, lineType);
+			_getBinaryLine(s, lineType);
+			break;
 		}
 
+		_file.getline(s, '\n');
+		if (!Text::_skippedLine(s))
+			break;
+
+		++_lineCount;
+		_cur = _file.tellg(std::ios::beg);
+	}
+
+	if (!_binary)
+	{
 		// Ignore header prefixes: "[PREFIX]Line of text..."
 		if (_header && s.find('[', 0) == 0)
 		{
@@ -951,46 +1108,165 @@ bool Text::nextLine(std::string &s, Text::LineType lineType)
 	return true;
 }
 
+// Read back the room and tag of a "[001:SCRP#0042]" header, as written by info()
+bool Text::_parseHeader(const std::string &s, int &lflfId, uint32 &tag)
+{
+	size_t i;
+
+	if (s.size() < 2 || s[0] != '[')
+		return false;
+
+	lflfId = 0;
+	for (i = 1; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i)
+		lflfId = lflfId * 10 + (s[i] - '0');
+
+	if (i == 1 || i >= s.size() || s[i] != ':')
+		return false;
+
+	tag = 0;
+	for (++i; i < s.size() && s[i] != '#' && s[i] != ']'; ++i)
+		tag = (tag << 8) | (byte)s[i];
+
+	return i < s.size() && s[i] == '#';
+}
+
+// Only read the lines of the blocks accepted by this function. Only works
+// with headers (-h), since they tell which block a line comes from.
+void Text::selectLines(Text::SelectFunc select)
+{
+	_select = select;
+}
+
 void Text::addExportHeaders()
 {
 	if (_comments && !_binary)
-		_file.write(internalCommentHeader());
+		_out += internalCommentHeader();
 }
 
-void Text::addLine(std::string s, Text::LineType lineType, int op)
+// rscType/rscId identify the resource name a line belongs to, if any. Such lines
+// are padded with '@' once all the names have been seen (see deferLines()).
+void Text::addLine(const std::string &s, Text::LineType lineType, int op, int rscType, int32 rscId)
 {
 	if (s.size() == 0) // empty lines are ignored
 		return;
 
-	if (lineType == Text::LT_OLDMSG)
-		Text::_spaceBitToChar(s);
+	if (_padding != nullptr)
+	{
+		_pending.push_back(Text::PendingLine(_lflfId, _tag, _id, s, lineType, op, rscType, rscId));
+		return;
+	}
+
+	_addLine(s, lineType, op);
+}
+
+// Holds the lines back until flushLines(), so that resource names can be padded
+// to their final length without exploring the game files twice
+void Text::deferLines(Text::PaddingFunc padding)
+{
+	_padding = padding;
+}
+
+void Text::flushLines()
+{
+	Text::PaddingFunc padding;
+	int32 n;
 
-	_file.seekp(0, std::ios::end);
+	padding = _padding;
+	_padding = nullptr;
+	if (padding == nullptr)
+		return;
+
+	for (std::list<Text::PendingLine>::iterator i = _pending.begin(); i != _pending.end(); ++i)
+	{
+		if (i->rscType >= 0 && (n = padding(i->rscType, i->rscId)) > (int32)i->s.size())
+			i->s.resize(n, '@');
+
+		setInfo(i->lflfId, i->tag, i->id);
+		_addLine(i->s, i->lineType, i->op);
+	}
+	_pending.clear();
+}
+
+void Text::_addLine(const std::string &line, Text::LineType lineType, int op)
+{
+	std::string oldMsg;
+	const std::string &s = (lineType == Text::LT_OLDMSG) ? oldMsg : line;
+
+	ScummStats::count(ScummStats::CNT_LINES_EXPORTED);
+
+	if (lineType == Text::LT_OLDMSG)
+	{
+		oldMsg = line;
+		Text::_spaceBitToChar(oldMsg);
+	}
 
 	if (_binary)
 	{
-		_file.write(s);
-		_file->putByte((byte)0);
+		_out += s;
+		_out += '\0';
 	}
 	else
 	{
 		if (_header)
-			_file.write(info());
+			_out += _lineHeader;
 
 		if (_opcode)
 		{
+			static const char hexDigits[] = "0123456789ABCDEF";
+
+			_out += '(';
 			if (op >= 0)
-				_file.write(xsprintf("(%.2X)", op));
+			{
+				_out += hexDigits[(op >> 4) & 0xF];
+				_out += hexDigits[op & 0xF];
+			}
 			else
-				_file.write(xsprintf("(__)"));
+			{
+				_out += "__";
+			}
+			_out += ')';
 		}
 
 		_writeEsc(s, lineType);
 	}
+
+	if (_out.size() >= Text::OUTPUT_BUFFER_SIZE)
+		_flushOutput();
+}
+
+// Exported lines are appended to a memory buffer, which is written in large
+// chunks instead of seeking to the end of the file for every line
+void Text::_flushOutput()
+{
+	if (_out.empty())
+		return;
+
+	ScummStats::Timer timer(ScummStats::PHS_TEXT_IO);
+
+	if (_buffer != nullptr)
+	{
+		_buffer->append(_out);
+	}
+	else
+	{
+		_file.seekp(0, std::ios::end);
+		_file.write(_out);
+	}
+	_out.resize(0);
+}
+
+void Text::flush()
+{
+	flushLines();
+	_flushOutput();
 }
 
 void Text::clear()
 {
+	_out.resize(0);
+	_pending.clear();
 	_file.truncate(0);
+	if (_buffer != nullptr)
+		_buffer->resize(0);
 	firstLine();
 }
@@ -29,6 +29,7 @@
 #include "common/types.hpp"
 #include "common/file.hpp"
 
+#include <list>
 #include <string>
 
 // TODO separate OutputText/InputText
@@ -74,6 +75,25 @@ public:
 	public:
 		Error(const std::string &message) : std::runtime_error(message) { }
 	};
+	typedef int32 (*PaddingFunc)(int rscType, int32 rscId);
+	typedef bool (*SelectFunc)(int lflfId, uint32 tag);
+
+private:
+	typedef int32 (*SpanFunc)(const byte *p, int32 n, int32 &i, bool atEnd);
+	struct PendingLine
+	{
+		int lflfId;
+		uint32 tag;
+		int id;
+		std::string s;
+		Text::LineType lineType;
+		int op;
+		int rscType;
+		int32 rscId;
+
+		PendingLine(int l, uint32 t, int i, const std::string &str, Text::LineType lt, int o, int rt, int32 ri) :
+			lflfId(l), tag(t), id(i), s(str), lineType(lt), op(o), rscType(rt), rscId(ri) { }
+	};
 
 private:
 	static const char CT_NULL[256];
@@ -85,7 +105,10 @@ private:
 	static const char *const CHARSETS[];
 
 private:
-	File _file;
+	File _diskFile;
+	RAMFile _memFile;
+	File &_file;
+	std::string *_buffer;
 	int32 _cur;
 	int32 _lineCount;
 	int _lflfId;
@@ -100,12 +123,25 @@ private:
 	bool _rawText;
 	const char *const _charset;
 	char _finalCharset[256];
+	char _charEsc[256][5];
+	char _funcEsc[256][5];
+	std::string _lineHeader;
+	std::string _out;
+	Text::PaddingFunc _padding;
+	Text::SelectFunc _select;
+	std::list<Text::PendingLine> _pending;
 
 private:
 	static void _checkMsg(const std::string &s, int l);
 	static void _checkRsc(const std::string &s, int l);
 	static void _checkOldMsg(const std::string &s, int l);
 	static void _checkPlain(const std::string &s, int l);
+	static int32 _spanRsc(const byte *p, int32 n, int32 &i, bool atEnd);
+	static int32 _spanOldMsg(const byte *p, int32 n, int32 &i, bool atEnd);
+	static int32 _spanMsg(const byte *p, int32 n, int32 &i, bool atEnd);
+	static int32 _spanPlain(const byte *p, int32 n, int32 &i, bool atEnd);
+	static int _getLength(FileHandle &f, Text::SpanFunc span);
+	static bool _parseHeader(const std::string &s, int &lflfId, uint32 &tag);
 
 public:
 	static int funcLen(byte c);
@@ -125,11 +161,18 @@ private:
 	void _spaceCharToBit(std::string &s) const;
 	void _spaceBitToChar(std::string &s) const;
 	void _unEsc(std::string &s, Text::LineType lineType) const;
-	void _writeChar(byte c);
-	void _writeEscChar(byte c);
+	void _initEscTables();
+	void _writeChar(byte c) { _out += _charEsc[c]; }
+	void _writeEscChar(byte c) { _out += _funcEsc[c]; }
 	void _getBinaryLine(std::string &s, Text::LineType lineType);
+	void _addLine(const std::string &line, Text::LineType lineType, int op);
+
+	void _flushOutput();
+	bool _skippedLine(const std::string &s) const;
+	bool _nextLine(std::string &s, Text::LineType lineType);
 
 	static const int MAX_QUICK_SAFETY_SCAN_LINES = 100;
+	static const size_t OUTPUT_BUFFER_SIZE = 0x100000;
 
 public:
 	void setInfo(int lflfId, uint32 tag, int id);
@@ -140,11 +183,15 @@ public:
 	bool nextLine(std::string &s, Text::LineType lineType);
 	void clear();
 	void addExportHeaders();
-	void addLine(std::string s, Text::LineType lineType, int op = -1);
+	void addLine(const std::string &s, Text::LineType lineType, int op = -1, int rscType = -1, int32 rscId = -1);
+	void deferLines(Text::PaddingFunc padding);
+	void selectLines(Text::SelectFunc select);
+	void flushLines();
+	void flush();
 	void ensureNoCrlfMisuse();
 
 public:
-	Text(const char *path, int flags, Text::Charset charset);
+	Text(const char *path, int flags, Text::Charset charset, std::string *buffer = nullptr);
 	~Text();
 
 private:
@@ -151,20 +151,6 @@ void ScriptBlock::exportText(Text &output, bool pad)
 	}
 }
 
-void ScriptBlock::getRscNameLimits()
-{
-	if (_script == nullptr)
-		_script = new Script(*_file, _headerSize, _file->size() - _headerSize);
-
-	try
-	{
-		_script->getRscNameLimits();
-	}
-	catch (Script::ParseError &)
-	{
-	}
-}
-
 /*
  * ObjectNameBlock
  */
@@ -231,24 +217,15 @@ void ObjectNameBlock::exportText(Text &output, bool pad)
 
 	output.setInfo(_lflfId(), _tag, _ownId());
 
-	if (pad && s.size() > 0 && ScummTr::getRscNameMaxLengh(ScummTr::RSCT_OBJECT, _id) > (int32)s.size())
-		s.resize(ScummTr::getRscNameMaxLengh(ScummTr::RSCT_OBJECT, _id), '@');
-
-	output.addLine(s, Text::LT_RSC);
-}
-
-void ObjectNameBlock::getRscNameLimits()
-{
-	int i;
-	byte b;
-
-	_file->seekg(_headerSize, std::ios::beg);
-
-	i = 0;
-	for (_file->getByte(b); b != 0; _file->getByte(b))
-		++i;
-
-	ScummTr::setRscNameMaxLengh(ScummTr::RSCT_OBJECT, _id, i);
+	if (pad && s.size() > 0)
+	{
+		ScummTr::setRscNameMaxLengh(ScummTr::RSCT_OBJECT, _id, (int32)s.size());
+		output.addLine(s, Text::LT_RSC, -1, ScummTr::RSCT_OBJECT, _id);
+	}
+	else
+	{
+		output.addLine(s, Text::LT_RSC);
+	}
 }
 
 /*
@@ -401,23 +378,6 @@ void ObjectCodeBlock::exportText(Text &output, bool pad)
 	}
 }
 
-void ObjectCodeBlock::getRscNameLimits()
-{
-	int32 o;
-
-	o = _findScriptOffset();
-	if (_script == nullptr)
-		_script = new Script(*_file, o, _file->size() - o);
-
-	try
-	{
-		_script->getRscNameLimits();
-	}
-	catch (Script::ParseError &)
-	{
-	}
-}
-
 /*
  * OldObjectCodeBlock
  */
@@ -476,10 +436,15 @@ void OldObjectCodeBlock::_exportName(Text &output, bool pad)
 	for (_file->getByte(b); b != 0; _file->getByte(b))
 		s += (char)b;
 
-	if (pad && s.size() > 0 && ScummTr::getRscNameMaxLengh(ScummTr::RSCT_OBJECT, _id) > (int32)s.size())
-		s.resize(ScummTr::getRscNameMaxLengh(ScummTr::RSCT_OBJECT, _id), '@');
-
-	output.addLine(s, Text::LT_RSC);
+	if (pad && s.size() > 0)
+	{
+		ScummTr::setRscNameMaxLengh(ScummTr::RSCT_OBJECT, _id, (int32)s.size());
+		output.addLine(s, Text::LT_RSC, -1, ScummTr::RSCT_OBJECT, _id);
+	}
+	else
+	{
+		output.addLine(s, Text::LT_RSC);
+	}
 }
 
 template <int I>
@@ -545,24 +510,6 @@ void OldObjectCodeBlock::exportText(Text &output, bool pad)
 	ObjectCodeBlock::exportText(output, pad);
 }
 
-void OldObjectCodeBlock::getRscNameLimits()
-{
-	int i;
-	byte b;
-
-	_file->seekg(0x0C + _headerSize, std::ios::beg);
-	_file->getByte(b);
-
-	_file->seekg(b, std::ios::beg);
-	i = 0;
-	for (_file->getByte(b); b != 0; _file->getByte(b))
-		++i;
-
-	ScummTr::setRscNameMaxLengh(ScummTr::RSCT_OBJECT, _id, i);
-
-	ObjectCodeBlock::getRscNameLimits();
-}
-
 /*
  * OldObjectCodeBlockV1
  */
@@ -620,21 +567,3 @@ void OldObjectCodeBlockV1::exportText(Text &output, bool pad)
 
 	ObjectCodeBlock::exportText(output, pad);
 }
-
-void OldObjectCodeBlockV1::getRscNameLimits()
-{
-	int i;
-	byte b;
-
-	_file->seekg(0x0A + _headerSize, std::ios::beg);
-	_file->getByte(b);
-
-	_file->seekg(b, std::ios::beg);
-	i = 0;
-	for (_file->getByte(b); b != 0; _file->getByte(b))
-		++i;
-
-	ScummTr::setRscNameMaxLengh(ScummTr::RSCT_OBJECT, _id, i);
-
-	ObjectCodeBlock::getRscNameLimits();
-}
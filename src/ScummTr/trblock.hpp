@@ -47,7 +47,6 @@ protected:
 public:
 	virtual void importText(Text &input) = 0;
 	virtual void exportText(Text &output, bool pad = false) = 0;
-	virtual void getRscNameLimits() = 0;
 
 public:
 	TextBlock();
@@ -70,7 +69,6 @@ protected:
 public:
 	void importText(Text &input) override;
 	void exportText(Text &output, bool pad = false) override;
-	void getRscNameLimits() override;
 
 public:
 	ScriptBlock(int32 subHeaderSize = 0);
@@ -94,7 +92,6 @@ class ObjectNameBlock : public TextBlock
 public:
 	void importText(Text &input) override;
 	void exportText(Text &output, bool pad = false) override;
-	void getRscNameLimits() override;
 
 public:
 	ObjectNameBlock();
@@ -137,7 +134,6 @@ protected:
 public:
 	void importText(Text &input) override;
 	void exportText(Text &output, bool pad = false) override;
-	void getRscNameLimits() override;
 
 public:
 	ObjectCodeBlock();
@@ -167,7 +163,6 @@ protected:
 public:
 	void importText(Text &input) override;
 	void exportText(Text &output, bool pad = false) override;
-	void getRscNameLimits() override;
 
 public:
 	OldObjectCodeBlock();
@@ -196,7 +191,6 @@ protected:
 public:
 	void importText(Text &input) override;
 	void exportText(Text &output, bool pad = false) override;
-	void getRscNameLimits() override;
 
 public:
 	OldObjectCodeBlockV1();
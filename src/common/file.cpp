@@ -25,6 +25,7 @@
 
 #include "common/file.hpp"
 #include "common/io.hpp"
+#include "common/stats.hpp"
 #include "common/toolbox.hpp"
 
 #include <cstring>
@@ -263,6 +264,19 @@ void File::copy(const char *src, const char *dest, bool failIfExists)
 	fSrc.close();
 }
 
+// Same as _onOpen(), for a file which only lives in memory: name is only
+// used in messages
+void File::_onOpenMemory(const char *name, std::streamsize size)
+{
+	_gpos = 0;
+	_ppos = 0;
+	_mode = std::ios::in | std::ios::out | std::ios::binary;
+	_path = xstrdup(name);
+	_part._zap();
+	_part._file = this;
+	_setSize(size);
+}
+
 void File::open(const char *filename, std::ios::openmode mode)
 {
 	_part._zap();
@@ -294,6 +308,8 @@ void File::close()
 
 File &File::seekg(std::streamoff off, std::ios::seekdir dir)
 {
+	SCUMMTR_IO_PROBE(IO_SEEKG, 0);
+
 	switch (dir)
 	{
 	case std::ios::beg:
@@ -316,6 +332,8 @@ File &File::seekg(std::streamoff off, std::ios::seekdir dir)
 
 File &File::seekp(std::streamoff off, std::ios::seekdir dir)
 {
+	SCUMMTR_IO_PROBE(IO_SEEKP, 0);
+
 	switch (dir)
 	{
 	case std::ios::beg:
@@ -402,6 +420,8 @@ File &File::getline(std::string &s, char delim)
 
 File &File::read(char *s, std::streamsize n)
 {
+	SCUMMTR_IO_PROBE(IO_READ, n);
+
 	if (n == 0)
 		return *this;
 
@@ -426,6 +446,8 @@ File &File::read(char *s, std::streamsize n)
 // only method which directly writes to _file
 File &File::write(const char *s, std::streamsize n)
 {
+	SCUMMTR_IO_PROBE(IO_WRITE, n);
+
 	if (n <= 0)
 		throw File::IOError(xsprintf("File::write: n <= 0 in: %s", _path));
 
@@ -468,6 +490,12 @@ File &File::write(FilePart &f, std::streamsize n)
 	return *this;
 }
 
+void File::willNeed(std::streamoff offset, std::streamsize n)
+{
+	if (_file.is_open() && offset >= 0 && n > 0)
+		xprefetch(_path, (long)offset, (long)n);
+}
+
 bool File::is_open()
 {
 	return _file.is_open();
@@ -480,6 +508,7 @@ std::streamsize File::size() const
 
 void File::_moveFwd(std::streamoff offset, std::streamsize n)
 {
+	SCUMMTR_IO_PROBE(IO_MOVE_FWD, n);
 	std::streamoff putPos, getPos, cpyPos, endPos;
 	std::streamsize chunkSize;
 	char chunk[File::CHUNK_SIZE];
@@ -512,6 +541,7 @@ void File::_moveFwd(std::streamoff offset, std::streamsize n)
 
 void File::_moveBwd(std::streamoff offset, std::streamsize n)
 {
+	SCUMMTR_IO_PROBE(IO_MOVE_BWD, n);
 	std::streamoff putPos, getPos, cpyPos, endPos;
 	std::streamsize chunkSize;
 	char chunk[File::CHUNK_SIZE];
@@ -547,6 +577,7 @@ void File::move(std::streamoff offset, std::streamsize n)
 	if (offset == 0 || n == 0)
 		return;
 
+	ScummStats::count(ScummStats::CNT_BYTES_MOVED, (double)n);
 	if (offset > 0)
 		_moveFwd(offset, n);
 	else
@@ -765,6 +796,8 @@ bool FilePart::eof()
 
 void FilePart::_xorBuffer(char *buffer, byte xorKey, std::streamsize n)
 {
+	SCUMMTR_IO_PROBE(IO_XOR, n);
+
 	if (xorKey == 0)
 		return;
 
@@ -825,6 +858,7 @@ FilePart &FilePart::read(char *s, std::streamsize n)
 	_file->read(s, n);
 	if (_xorKey != 0)
 		FilePart::_xorBuffer(s, _xorKey, n);
+	ScummStats::count(ScummStats::CNT_BYTES_READ, (double)n);
 
 	return *this;
 }
@@ -869,6 +903,7 @@ FilePart &FilePart::write(const char *s, std::streamsize n)
 		}
 		delete[] xored;
 	}
+	ScummStats::count(ScummStats::CNT_BYTES_WRITTEN, (double)n);
 
 	return *this;
 }
@@ -915,6 +950,11 @@ std::streamoff FilePart::offset() const
 	return _offset;
 }
 
+void FilePart::willNeed(std::streamoff offset, std::streamsize n)
+{
+	_file->willNeed(_offset + offset, n);
+}
+
 std::streamoff FilePart::fullOffset() const
 {
 	return _offset;
@@ -1028,6 +1068,21 @@ void FilePart::put(T i)
 }
 
 // for GCC
+// Read n values with a single read() (and a single XOR pass), then fix
+// their byte order in place
+template <bool B, class T>
+void FilePart::_readArray(T *a, int n)
+{
+	if (n <= 0)
+		return;
+
+	read((char *)a, n * (std::streamsize)sizeof *a);
+
+	if (cpu_is_little_endian() == B)
+		for (int i = 0; i < n; ++i)
+			FilePart::_reverse(a[i]);
+}
+
 void FilePart::getLE(byte &i) { get<false, byte>(i); }
 void FilePart::getLE(uint16 &i) { get<false, uint16>(i); }
 void FilePart::putLE(byte &i) { put<false, byte>(i); }
@@ -1133,6 +1188,26 @@ void FilePart::putBE32(int32 i)
 	put<true, uint32>((uint32 &)i);
 }
 
+void FilePart::readLE16Array(uint16 *a, int n)
+{
+	_readArray<false, uint16>(a, n);
+}
+
+void FilePart::readLE32Array(uint32 *a, int n)
+{
+	_readArray<false, uint32>(a, n);
+}
+
+void FilePart::readLE32Array(int32 *a, int n)
+{
+	_readArray<false, uint32>((uint32 *)a, n);
+}
+
+void FilePart::readBE32Array(uint32 *a, int n)
+{
+	_readArray<true, uint32>(a, n);
+}
+
 /*
  * RAMFile
  */
@@ -1187,20 +1262,47 @@ void RAMFile::_save()
 	}
 }
 
-void RAMFile::_reallocAtLeast(std::streamsize sz)
+void RAMFile::_realloc(std::streamsize capacity)
 {
 	byte *buffer;
-	std::streamsize oldCapacity;
 
-	oldCapacity = _capacity;
-	_capacity = (sz / File::CHUNK_SIZE + 1) * File::CHUNK_SIZE;
-	buffer = new byte[_capacity];
+	capacity = (capacity / File::CHUNK_SIZE + 1) * File::CHUNK_SIZE;
+	buffer = new byte[capacity];
 
 	if (_mem != nullptr)
-		std::memcpy(buffer, _mem, oldCapacity);
+		std::memcpy(buffer, _mem, std::min(_size, _capacity));
 
 	delete[] _mem;
 	_mem = buffer;
+	_capacity = capacity;
+}
+
+// Grow by at least half of the current capacity, so that a file which keeps
+// growing by small steps isn't copied over and over
+void RAMFile::_reallocAtLeast(std::streamsize sz)
+{
+	SCUMMTR_IO_PROBE(IO_REALLOC, _size);
+
+	_realloc(std::max(sz, _capacity + _capacity / 2));
+}
+
+void RAMFile::reserve(std::streamsize sz)
+{
+	if (sz > _capacity)
+		_realloc(sz);
+}
+
+// Works on a copy of data, with no file behind it: nothing is saved when
+// it's closed
+void RAMFile::openMemory(const char *name, const std::string &data)
+{
+	close();
+
+	_reallocAtLeast((std::streamsize)data.size());
+	if (!data.empty())
+		std::memcpy(_mem, data.data(), data.size());
+	_onOpenMemory(name, (std::streamsize)data.size());
+	_out = true;
 }
 
 void RAMFile::_zapRAM()
@@ -1266,6 +1368,8 @@ File &RAMFile::getline(std::string &s, char delim)
 
 File &RAMFile::read(char *s, std::streamsize n)
 {
+	SCUMMTR_IO_PROBE(IO_READ, n);
+
 	if (n == 0)
 		return *this;
 
@@ -1284,6 +1388,8 @@ File &RAMFile::read(char *s, std::streamsize n)
 // only method which directly writes to _mem
 File &RAMFile::write(const char *s, std::streamsize n)
 {
+	SCUMMTR_IO_PROBE(IO_WRITE, n);
+
 	if (_ppos < 0 || n <= 0 || !_out)
 		throw File::IOError(xsprintf("RAMFile::write: %s", _path));
 
@@ -1297,3 +1403,252 @@ File &RAMFile::write(const char *s, std::streamsize n)
 
 	return *this;
 }
+
+/*
+ * PagedFile
+ */
+
+std::streamsize PagedFile::_defaultBudget = PagedFile::DEFAULT_BUDGET;
+
+PagedFile::PagedFile() :
+    File(), _pages(), _pageMap(), _budget(0), _diskSize(0), _out(false)
+{
+}
+
+PagedFile::~PagedFile()
+{
+	if (is_open())
+		_flushPages();
+
+	_zapPages();
+}
+
+void PagedFile::setBudget(std::streamsize budget)
+{
+	_defaultBudget = budget;
+}
+
+void PagedFile::_zapPages()
+{
+	for (PageList::iterator i = _pages.begin(); i != _pages.end(); ++i)
+		delete[] i->data;
+
+	_pages.clear();
+	_pageMap.clear();
+	_gpos = 0;
+	_ppos = 0;
+	_diskSize = 0;
+	_out = false;
+}
+
+void PagedFile::_zap()
+{
+	File::_zap();
+	_zapPages();
+}
+
+void PagedFile::_loadPage(Page &page)
+{
+	std::streamoff start;
+	std::streamsize n;
+
+	start = page.index * PagedFile::PAGE_SIZE;
+	n = 0;
+	if (start < _diskSize)
+	{
+		n = _diskSize - start;
+		if (n > PagedFile::PAGE_SIZE)
+			n = PagedFile::PAGE_SIZE;
+
+		_file.seekg(start, std::ios::beg);
+		_file.read((char *)page.data, n);
+		if (_file.fail())
+			throw File::IOError(xsprintf("PagedFile::read: %s", _path));
+
+		_seekedg = _seekedp = true;
+	}
+
+	std::memset(page.data + n, 0, PagedFile::PAGE_SIZE - n);
+}
+
+void PagedFile::_savePage(Page &page)
+{
+	static const char zeros[File::CHUNK_SIZE] = { 0 };
+	std::streamoff start;
+	std::streamsize n;
+
+	start = page.index * PagedFile::PAGE_SIZE;
+	if (!page.dirty || start >= _size)
+		return;
+
+	n = _size - start;
+	if (n > PagedFile::PAGE_SIZE)
+		n = PagedFile::PAGE_SIZE;
+
+	// fill the hole, if the file was grown beyond its size on disk
+	_file.seekp(std::min(start, (std::streamoff)_diskSize), std::ios::beg);
+	for (std::streamsize gap = start - _diskSize; gap > 0; gap -= File::CHUNK_SIZE)
+		_file.write(zeros, gap < File::CHUNK_SIZE ? gap : File::CHUNK_SIZE);
+
+	_file.write((const char *)page.data, n);
+	if (_file.fail())
+		throw File::IOError(xsprintf("PagedFile::write: %s", _path));
+
+	_seekedg = _seekedp = true;
+	if (start + n > _diskSize)
+		_diskSize = start + n;
+	page.dirty = false;
+}
+
+// Pages are written back in file order, so that holes are seldom filled
+void PagedFile::_flushPages()
+{
+	if (!_out)
+		return;
+
+	for (PageMap::iterator i = _pageMap.begin(); i != _pageMap.end(); ++i)
+		_savePage(*i->second);
+}
+
+byte *PagedFile::_page(std::streamoff index, bool dirty)
+{
+	PageMap::iterator i;
+	Page page;
+
+	i = _pageMap.find(index);
+	if (i != _pageMap.end())
+	{
+		if (i->second != _pages.begin())
+			_pages.splice(_pages.begin(), _pages, i->second);
+	}
+	else
+	{
+		if (!_pages.empty() && (std::streamsize)(_pageMap.size() + 1) * PagedFile::PAGE_SIZE > _budget)
+		{
+			// recycle the least recently used page
+			page = _pages.back();
+			_savePage(page);
+			_pageMap.erase(page.index);
+			_pages.pop_back();
+		}
+		else
+		{
+			page.data = new byte[PagedFile::PAGE_SIZE];
+		}
+
+		page.index = index;
+		page.dirty = false;
+		try
+		{
+			_loadPage(page);
+		}
+		catch (...)
+		{
+			delete[] page.data;
+			throw;
+		}
+		_pages.push_front(page);
+		_pageMap.insert(std::make_pair(index, _pages.begin()));
+	}
+
+	if (dirty)
+		_pages.front().dirty = true;
+
+	return _pages.front().data;
+}
+
+void PagedFile::open(const char *filename, std::ios::openmode mode)
+{
+	File::open(filename, mode);
+
+	_budget = _defaultBudget;
+	_diskSize = is_open() ? _size : 0;
+	_out = (mode & std::ios::out) != 0;
+}
+
+void PagedFile::close()
+{
+	if (is_open())
+		_flushPages();
+
+	File::close();
+	_zap();
+}
+
+File &PagedFile::getline(std::string &s, char delim)
+{
+	std::streamoff offset;
+	std::streamsize n;
+	const byte *data, *end;
+
+	s.resize(0);
+	while (_gpos < _size)
+	{
+		offset = _gpos % PagedFile::PAGE_SIZE;
+		n = std::min((std::streamsize)(PagedFile::PAGE_SIZE - offset), (std::streamsize)(_size - _gpos));
+		data = _page(_gpos / PagedFile::PAGE_SIZE, false) + offset;
+		end = (const byte *)std::memchr(data, delim, n);
+		if (end != nullptr)
+		{
+			s.append((const char *)data, end - data);
+			_gpos += (end - data) + 1;
+			break;
+		}
+		s.append((const char *)data, n);
+		_gpos += n;
+	}
+
+	return *this;
+}
+
+File &PagedFile::read(char *s, std::streamsize n)
+{
+	SCUMMTR_IO_PROBE(IO_READ, n);
+	std::streamoff offset;
+	std::streamsize len;
+
+	if (n == 0)
+		return *this;
+
+	if ((std::streamsize)_gpos + n > _size)
+		throw File::UnexpectedEOF(xsprintf("Unexpected EOF in: %s", _path));
+
+	if (_gpos < 0 || n < 0)
+		throw File::IOError(xsprintf("PagedFile::read: %s", _path));
+
+	while (n > 0)
+	{
+		offset = _gpos % PagedFile::PAGE_SIZE;
+		len = std::min((std::streamsize)(PagedFile::PAGE_SIZE - offset), n);
+		std::memcpy(s, _page(_gpos / PagedFile::PAGE_SIZE, false) + offset, len);
+		s += len;
+		n -= len;
+		_gpos += len;
+	}
+
+	return *this;
+}
+
+File &PagedFile::write(const char *s, std::streamsize n)
+{
+	SCUMMTR_IO_PROBE(IO_WRITE, n);
+	std::streamoff offset;
+	std::streamsize len;
+
+	if (_ppos < 0 || n <= 0 || !_out)
+		throw File::IOError(xsprintf("PagedFile::write: %s", _path));
+
+	while (n > 0)
+	{
+		offset = _ppos % PagedFile::PAGE_SIZE;
+		len = std::min((std::streamsize)(PagedFile::PAGE_SIZE - offset), n);
+		std::memcpy(_page(_ppos / PagedFile::PAGE_SIZE, true) + offset, s, len);
+		s += len;
+		n -= len;
+		_ppos += len;
+		if (_size < _ppos)
+			_setSize(_ppos);
+	}
+
+	return *this;
+}
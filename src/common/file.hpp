@@ -33,11 +33,13 @@
 #include <fstream>
 #include <iostream>
 #include <list>
+#include <map>
 #include <stdexcept>
 #include <string>
 
 class File;
 class RAMFile;
+class PagedFile;
 template <class T> class SeqFile;
 class FilePart;
 class FileHandle;
@@ -84,8 +86,8 @@ private:
 
 private:
 	static void _reverse(uint8 &) { }
-	static void _reverse(uint16 &i) { i = ((i << 8) & 0xff00) | ((i >> 8) & 0x00ff); }
-	static void _reverse(uint32 &i) { i = ((i << 24) & 0xff000000) | ((i << 8) & 0x00ff0000) | ((i >> 8) & 0x0000ff00) | ((i >> 24) & 0x000000ff); }
+	static void _reverse(uint16 &i) { i = scummtr_bswap16(i); }
+	static void _reverse(uint32 &i) { i = scummtr_bswap32(i); }
 	static void _xorBuffer(char *buffer, byte xorKey, std::streamsize n);
 
 private:
@@ -94,6 +96,7 @@ private:
 	void _shiftFrame(std::streamoff start, std::streamoff shift);
 	void _leaveParent();
 	void _adopt(FilePart &f);
+	template <bool B, class T> void _readArray(T *a, int n);
 
 public:
 	bool eof();
@@ -132,6 +135,10 @@ public:
 	void putLE32(int32 i);
 	void putBE16(int16 i);
 	void putBE32(int32 i);
+	void readLE16Array(uint16 *a, int n);
+	void readLE32Array(uint32 *a, int n);
+	void readLE32Array(int32 *a, int n);
+	void readBE32Array(uint32 *a, int n);
 	FilePart &seekg(std::streamoff off, std::ios::seekdir dir);
 	FilePart &seekp(std::streamoff off, std::ios::seekdir dir);
 	std::streamoff tellg(std::ios::seekdir dir);
@@ -142,6 +149,7 @@ public:
 	FilePart &write(const char *s, std::streamsize n);
 	FilePart &write(FilePart &f, std::streamsize n);
 	FilePart &write(File &f, std::streamsize n);
+	void willNeed(std::streamoff offset, std::streamsize n);
 
 public:
 	FilePart(File &file);
@@ -210,6 +218,7 @@ public:
 protected:
 	std::streamsize _getStreamSize();
 	void _onOpen(const char *filename, std::ios::openmode mode);
+	void _onOpenMemory(const char *name, std::streamsize size);
 	void _truncateAndClose();
 	void _moveFwd(std::streamoff offset, std::streamsize n);
 	void _moveBwd(std::streamoff offset, std::streamsize n);
@@ -240,6 +249,7 @@ public:
 	virtual File &read(char *s, std::streamsize n);
 	virtual File &write(const char *s, std::streamsize n);
 	virtual File &getline(std::string &s, char delim);
+	virtual void willNeed(std::streamoff offset, std::streamsize n);
 
 public:
 	File();
@@ -307,6 +317,7 @@ protected:
 	void _zapRAM();
 	void _load();
 	void _save();
+	void _realloc(std::streamsize capacity);
 	void _reallocAtLeast(std::streamsize sz);
 
 public:
@@ -315,6 +326,9 @@ public:
 	File &read(char *s, std::streamsize n) override;
 	File &write(const char *s, std::streamsize n) override;
 	File &getline(std::string &s, char delim) override;
+	void willNeed(std::streamoff, std::streamsize) override { }
+	void reserve(std::streamsize sz);
+	void openMemory(const char *name, const std::string &data);
 
 public:
 	RAMFile();
@@ -326,6 +340,65 @@ private: // Not copiable
 	RAMFile &operator=(const RAMFile &);
 };
 
+/*
+ * PagedFile
+ */
+
+// Keeps at most a fixed number of pages of the file in memory. The least
+// recently used page is written back (if dirty) when a new one is needed.
+class PagedFile : public File
+{
+public:
+	static const int PAGE_SIZE = 0x10000;
+	static const std::streamsize DEFAULT_BUDGET = 0x4000000;
+
+protected:
+	struct Page
+	{
+		std::streamoff index;
+		bool dirty;
+		byte *data;
+	};
+	typedef std::list<Page> PageList;
+	typedef std::map<std::streamoff, PageList::iterator> PageMap;
+
+protected:
+	static std::streamsize _defaultBudget;
+
+protected:
+	PageList _pages; // most recently used first
+	PageMap _pageMap;
+	std::streamsize _budget;
+	std::streamsize _diskSize;
+	bool _out;
+
+protected:
+	void _zap() override;
+	void _zapPages();
+	byte *_page(std::streamoff index, bool dirty);
+	void _loadPage(Page &page);
+	void _savePage(Page &page);
+	void _flushPages();
+
+public:
+	static void setBudget(std::streamsize budget);
+
+public:
+	void open(const char *filename, std::ios::openmode mode = std::ios::in | std::ios::out | std::ios::binary) override;
+	void close() override;
+	File &read(char *s, std::streamsize n) override;
+	File &write(const char *s, std::streamsize n) override;
+	File &getline(std::string &s, char delim) override;
+
+public:
+	PagedFile();
+	~PagedFile() override;
+
+private: // Not copiable
+	PagedFile(const PagedFile &);
+	PagedFile &operator=(const PagedFile &);
+};
+
 /*
  * SeqFile
  */
@@ -394,6 +467,19 @@ public:
 	{
 		throw std::logic_error("SeqFile::getline: Shouldn't be here");
 	}
+	// what hasn't been copied yet still has to be read from the source file
+	virtual void willNeed(std::streamoff offset, std::streamsize n)
+	{
+		// what is before _tmpSize was already copied from the source file
+		if (offset < _tmpSize)
+		{
+			n -= _tmpSize - offset;
+			offset = _tmpSize;
+		}
+
+		if (n > 0)
+			_srcFile.willNeed(offset - _shift, n);
+	}
 	virtual File &read(char *s, std::streamsize n)
 	{
 		std::streamoff gpos, ppos;
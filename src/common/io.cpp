@@ -27,6 +27,7 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <stdexcept>
 
 /*
  * ScummIO
@@ -34,6 +35,7 @@
 
 uint32 ScummIO::_infoSlots = 0;
 bool ScummIO::_quiet = false;
+bool ScummIO::_throwOnFatal = false;
 
 void ScummIO::info(int slots, const char *msg)
 {
@@ -43,12 +45,20 @@ void ScummIO::info(int slots, const char *msg)
 
 void ScummIO::crash(const char *msg)
 {
+	// an internal error, but the host program may still go on
+	if (ScummIO::_throwOnFatal)
+		throw std::logic_error(msg);
+
 	std::cerr << "CRASH: " << msg << std::endl;
 	std::abort();
 }
 
 void ScummIO::fatal(const char *msg)
 {
+	// don't take the whole process down when running as a library
+	if (ScummIO::_throwOnFatal)
+		throw std::runtime_error(msg);
+
 	std::cerr << "ERROR: " << msg << std::endl;
 	std::exit(EXIT_FAILURE);
 }
@@ -71,6 +81,17 @@ void ScummIO::setQuiet(bool q)
 	ScummIO::_quiet = q;
 }
 
+// Returns the previous setting, so that it can be restored
+bool ScummIO::setThrowOnFatal(bool t)
+{
+	bool previous;
+
+	previous = ScummIO::_throwOnFatal;
+	ScummIO::_throwOnFatal = t;
+
+	return previous;
+}
+
 void ScummIO::setInfoSlots(uint32 infoSlots)
 {
 	ScummIO::_infoSlots = infoSlots;
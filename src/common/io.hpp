@@ -42,6 +42,7 @@ class ScummIO
 {
 private:
 	static bool _quiet;
+	static bool _throwOnFatal;
 	static uint32 _infoSlots;
 
 public:
@@ -51,6 +52,7 @@ public:
 	SCUMMTR_NORETURN_PREFIX static void fatal(const char *msg) __attribute__((noreturn));
 	SCUMMTR_NORETURN_PREFIX static void crash(const char *msg) __attribute__((noreturn));
 	static void setQuiet(bool q);
+	static bool setThrowOnFatal(bool t);
 	static void setInfoSlots(uint32 infoSlots);
 };
 
@@ -0,0 +1,269 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2026 Donovan Watteau
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "common/stats.hpp"
+#include "common/toolbox.hpp"
+
+#include <ctime>
+#include <iostream>
+#include <string>
+
+#if defined(_WIN32) && !defined(__DJGPP__)
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <sys/time.h>
+#endif
+
+/*
+ * ScummStats
+ */
+
+ScummStats::Format ScummStats::_format = ScummStats::FMT_NULL;
+double ScummStats::_counters[ScummStats::CNT_COUNT] = { 0 };
+double ScummStats::_wall[ScummStats::PHS_COUNT] = { 0 };
+double ScummStats::_cpu[ScummStats::PHS_COUNT] = { 0 };
+int ScummStats::_calls[ScummStats::PHS_COUNT] = { 0 };
+#ifdef SCUMMTR_IO_ACCOUNTING
+double ScummStats::_ioCalls[ScummStats::IO_COUNT] = { 0 };
+double ScummStats::_ioBytes[ScummStats::IO_COUNT] = { 0 };
+double ScummStats::_ioWall[ScummStats::IO_COUNT] = { 0 };
+double ScummStats::_ioSizes[ScummStats::IO_COUNT][ScummStats::IO_BUCKETS] = { { 0 } };
+#endif
+
+static const char *const phaseNames[ScummStats::PHS_COUNT] =
+{
+	"index_load", "disk", "lflf", "script_parse", "text_io", "index_save"
+};
+
+static const char *const counterNames[ScummStats::CNT_COUNT] =
+{
+	"blocks", "scripts", "lines_exported", "lines_imported", "bytes_read", "bytes_written", "bytes_moved"
+};
+
+#ifdef SCUMMTR_IO_ACCOUNTING
+static const char *const ioNames[ScummStats::IO_COUNT] =
+{
+	"read", "write", "seekg", "seekp", "move_fwd", "move_bwd", "realloc", "xor"
+};
+
+// bucket 0 is for empty requests, bucket i for sizes in [2^(i-1), 2^i)
+static int ioBucket(double n)
+{
+	int i;
+
+	for (i = 0; n >= 1 && i < ScummStats::IO_BUCKETS - 1; ++i)
+		n /= 2;
+
+	return i;
+}
+
+static std::string ioBucketName(int i)
+{
+	if (i == 0)
+		return "0";
+	if (i == 1)
+		return "1";
+	if (i == ScummStats::IO_BUCKETS - 1)
+		return xsprintf("%li+", 1L << (i - 1));
+
+	return xsprintf("%li-%li", 1L << (i - 1), (1L << i) - 1);
+}
+#endif
+
+double ScummStats::_wallClock()
+{
+#if defined(_WIN32) && !defined(__DJGPP__)
+	return GetTickCount() / 1000.0;
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, nullptr);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+#endif
+}
+
+double ScummStats::_cpuClock()
+{
+	return (double)std::clock() / CLOCKS_PER_SEC;
+}
+
+void ScummStats::enable(ScummStats::Format format)
+{
+	ScummStats::reset();
+	ScummStats::_format = format;
+}
+
+void ScummStats::reset()
+{
+	ScummStats::_format = ScummStats::FMT_NULL;
+	for (int i = 0; i < ScummStats::CNT_COUNT; ++i)
+		ScummStats::_counters[i] = 0;
+
+	for (int i = 0; i < ScummStats::PHS_COUNT; ++i)
+	{
+		ScummStats::_wall[i] = ScummStats::_cpu[i] = 0;
+		ScummStats::_calls[i] = 0;
+	}
+#ifdef SCUMMTR_IO_ACCOUNTING
+	for (int i = 0; i < ScummStats::IO_COUNT; ++i)
+	{
+		ScummStats::_ioCalls[i] = ScummStats::_ioBytes[i] = ScummStats::_ioWall[i] = 0;
+		for (int j = 0; j < ScummStats::IO_BUCKETS; ++j)
+			ScummStats::_ioSizes[i][j] = 0;
+	}
+#endif
+}
+
+// Phases may be nested (scripts are parsed while an LFLF is walked), so
+// their times overlap
+void ScummStats::report(const char *tool)
+{
+	if (ScummStats::_format == ScummStats::FMT_JSON)
+	{
+		std::cout << "{\"tool\":\"" << tool << "\",\"phases\":{";
+		for (int i = 0; i < ScummStats::PHS_COUNT; ++i)
+			std::cout << (i > 0 ? "," : "") << xsprintf("\"%s\":{\"calls\":%i,\"wall\":%.3f,\"cpu\":%.3f}",
+			    phaseNames[i], ScummStats::_calls[i], ScummStats::_wall[i], ScummStats::_cpu[i]);
+		std::cout << "},\"counters\":{";
+		for (int i = 0; i < ScummStats::CNT_COUNT; ++i)
+			std::cout << (i > 0 ? "," : "") << xsprintf("\"%s\":%.0f", counterNames[i], ScummStats::_counters[i]);
+		std::cout << "}";
+#ifdef SCUMMTR_IO_ACCOUNTING
+		ScummStats::_reportIO();
+#endif
+		std::cout << "}" << std::endl;
+	}
+	else if (ScummStats::_format == ScummStats::FMT_TEXT)
+	{
+		std::cout << "\n" << tool << " statistics:\n\n";
+		std::cout << xsprintf("%-16s %8s %10s %10s", "phase", "calls", "wall (s)", "cpu (s)") << "\n";
+		for (int i = 0; i < ScummStats::PHS_COUNT; ++i)
+			std::cout << xsprintf("%-16s %8i %10.3f %10.3f", phaseNames[i], ScummStats::_calls[i], ScummStats::_wall[i], ScummStats::_cpu[i]) << "\n";
+		std::cout << "\n";
+		for (int i = 0; i < ScummStats::CNT_COUNT; ++i)
+			std::cout << xsprintf("%-16s %.0f", counterNames[i], ScummStats::_counters[i]) << "\n";
+#ifdef SCUMMTR_IO_ACCOUNTING
+		ScummStats::_reportIO();
+#endif
+		std::cout << std::flush;
+	}
+}
+
+#ifdef SCUMMTR_IO_ACCOUNTING
+// Counts are per File operation, whatever the kind of File (fstream, RAM,
+// paged), so that they can be compared with the logical bytes_* counters
+void ScummStats::_reportIO()
+{
+	if (ScummStats::_format == ScummStats::FMT_JSON)
+	{
+		std::cout << ",\"io\":{";
+		for (int i = 0; i < ScummStats::IO_COUNT; ++i)
+		{
+			std::cout << (i > 0 ? "," : "") << xsprintf("\"%s\":{\"calls\":%.0f,\"bytes\":%.0f,\"wall\":%.3f,\"sizes\":[",
+			    ioNames[i], ScummStats::_ioCalls[i], ScummStats::_ioBytes[i], ScummStats::_ioWall[i]);
+			for (int j = 0; j < ScummStats::IO_BUCKETS; ++j)
+				std::cout << (j > 0 ? "," : "") << xsprintf("%.0f", ScummStats::_ioSizes[i][j]);
+			std::cout << "]}";
+		}
+		std::cout << "}";
+	}
+	else if (ScummStats::_format == ScummStats::FMT_TEXT)
+	{
+		std::cout << "\n" << xsprintf("%-16s %12s %14s %10s", "io", "calls", "bytes", "wall (s)") << "\n";
+		for (int i = 0; i < ScummStats::IO_COUNT; ++i)
+			std::cout << xsprintf("%-16s %12.0f %14.0f %10.3f", ioNames[i], ScummStats::_ioCalls[i], ScummStats::_ioBytes[i], ScummStats::_ioWall[i]) << "\n";
+
+		std::cout << "\n" << xsprintf("%-16s", "request size");
+		for (int i = 0; i < ScummStats::IO_COUNT; ++i)
+			std::cout << xsprintf(" %9s", ioNames[i]);
+		std::cout << "\n";
+		for (int j = 0; j < ScummStats::IO_BUCKETS; ++j)
+		{
+			bool used = false;
+
+			for (int i = 0; i < ScummStats::IO_COUNT; ++i)
+				used = used || ScummStats::_ioSizes[i][j] > 0;
+			if (!used)
+				continue;
+
+			std::cout << xsprintf("%-16s", ioBucketName(j).c_str());
+			for (int i = 0; i < ScummStats::IO_COUNT; ++i)
+				std::cout << xsprintf(" %9.0f", ScummStats::_ioSizes[i][j]);
+			std::cout << "\n";
+		}
+	}
+}
+#endif
+
+/*
+ * ScummStats::Timer
+ */
+
+ScummStats::Timer::Timer(ScummStats::Phase phase) :
+    _phase(phase), _running(ScummStats::enabled()), _wall(0), _cpu(0)
+{
+	if (!_running)
+		return;
+
+	_wall = ScummStats::_wallClock();
+	_cpu = ScummStats::_cpuClock();
+}
+
+ScummStats::Timer::~Timer()
+{
+	if (!_running || !ScummStats::enabled())
+		return;
+
+	ScummStats::_wall[_phase] += ScummStats::_wallClock() - _wall;
+	ScummStats::_cpu[_phase] += ScummStats::_cpuClock() - _cpu;
+	++ScummStats::_calls[_phase];
+}
+
+#ifdef SCUMMTR_IO_ACCOUNTING
+/*
+ * ScummStats::IOProbe
+ */
+
+ScummStats::IOProbe::IOProbe(ScummStats::IOOperation op, double n) :
+    _op(op), _running(ScummStats::enabled()), _wall(0)
+{
+	if (!_running)
+		return;
+
+	++ScummStats::_ioCalls[op];
+	ScummStats::_ioBytes[op] += n;
+	++ScummStats::_ioSizes[op][ioBucket(n)];
+	_wall = ScummStats::_wallClock();
+}
+
+ScummStats::IOProbe::~IOProbe()
+{
+	if (!_running || !ScummStats::enabled())
+		return;
+
+	ScummStats::_ioWall[_op] += ScummStats::_wallClock() - _wall;
+}
+#endif
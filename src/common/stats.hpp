@@ -0,0 +1,158 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2026 Donovan Watteau
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SCUMM_COMMON_STATS_HPP
+#define SCUMM_COMMON_STATS_HPP
+
+#include "common/types.hpp"
+
+/*
+ * ScummStats
+ */
+
+// Time spent in the main phases of a run, and a few counters, reported
+// with --stats. Nothing is measured unless it was enabled.
+class ScummStats
+{
+public:
+	enum Phase
+	{
+		PHS_INDEX_LOAD = 0,
+		PHS_DISK,
+		PHS_LFLF,
+		PHS_SCRIPT_PARSE,
+		PHS_TEXT_IO,
+		PHS_INDEX_SAVE,
+		PHS_COUNT
+	};
+	enum Counter
+	{
+		CNT_BLOCKS = 0,
+		CNT_SCRIPTS,
+		CNT_LINES_EXPORTED,
+		CNT_LINES_IMPORTED,
+		CNT_BYTES_READ,
+		CNT_BYTES_WRITTEN,
+		CNT_BYTES_MOVED,
+		CNT_COUNT
+	};
+	enum Format
+	{
+		FMT_NULL = 0,
+		FMT_TEXT,
+		FMT_JSON
+	};
+#ifdef SCUMMTR_IO_ACCOUNTING
+	enum IOOperation
+	{
+		IO_READ = 0,
+		IO_WRITE,
+		IO_SEEKG,
+		IO_SEEKP,
+		IO_MOVE_FWD,
+		IO_MOVE_BWD,
+		IO_REALLOC,
+		IO_XOR,
+		IO_COUNT
+	};
+	// request sizes: 0, 1, 2-3, 4-7, ..., 4 MB and more
+	static const int IO_BUCKETS = 24;
+#endif
+
+public:
+	class Timer
+	{
+	private:
+		ScummStats::Phase _phase;
+		bool _running;
+		double _wall;
+		double _cpu;
+
+	public:
+		Timer(ScummStats::Phase phase);
+		~Timer();
+
+	private: // Not copiable
+		Timer(const Timer &);
+		Timer &operator=(const Timer &);
+	};
+
+#ifdef SCUMMTR_IO_ACCOUNTING
+	// Only compiled in with SCUMMTR_IO_ACCOUNTING: accounts for one call to
+	// a low-level File operation. Calls may be nested (File::move() reads
+	// and writes), and the probe itself adds to the times it measures.
+	class IOProbe
+	{
+	private:
+		ScummStats::IOOperation _op;
+		bool _running;
+		double _wall;
+
+	public:
+		IOProbe(ScummStats::IOOperation op, double n);
+		~IOProbe();
+
+	private: // Not copiable
+		IOProbe(const IOProbe &);
+		IOProbe &operator=(const IOProbe &);
+	};
+#endif
+
+private:
+	static ScummStats::Format _format;
+	static double _counters[CNT_COUNT];
+	static double _wall[PHS_COUNT];
+	static double _cpu[PHS_COUNT];
+	static int _calls[PHS_COUNT];
+#ifdef SCUMMTR_IO_ACCOUNTING
+	static double _ioCalls[IO_COUNT];
+	static double _ioBytes[IO_COUNT];
+	static double _ioWall[IO_COUNT];
+	static double _ioSizes[IO_COUNT][IO_BUCKETS];
+#endif
+
+private:
+	static double _wallClock();
+	static double _cpuClock();
+#ifdef SCUMMTR_IO_ACCOUNTING
+	static void _reportIO();
+#endif
+
+public:
+	static void enable(ScummStats::Format format);
+	static void reset();
+	static void report(const char *tool);
+	static bool enabled() { return ScummStats::_format != ScummStats::FMT_NULL; }
+	// byte counts may exceed 32 bits, hence the doubles
+	static void count(ScummStats::Counter c, double n = 1) { if (ScummStats::enabled()) ScummStats::_counters[c] += n; }
+};
+
+#ifdef SCUMMTR_IO_ACCOUNTING
+#  define SCUMMTR_IO_PROBE(op, n)	ScummStats::IOProbe ioProbe_(ScummStats::op, (double)(n))
+#else
+#  define SCUMMTR_IO_PROBE(op, n)
+#endif
+
+#endif
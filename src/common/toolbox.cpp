@@ -29,25 +29,35 @@
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
+#include <ctime>
 
 #include <iostream>
+#include <set>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 #if defined(_WIN32) && !defined(__DJGPP__)
 #  include <direct.h>
+#  include <io.h>
+#  include <sys/types.h>
+#  include <sys/stat.h>
 #  define mkdir(path, mode) _mkdir(path)
 #else /* assume Unix */
 #  include <sys/types.h>
 #  include <sys/stat.h>
+#  include <dirent.h>
+#  include <fcntl.h>
+#  include <unistd.h>
 #endif
 
 const char *xsprintf(_Printf_format_string_ const char *format, ...)
 {
 	static const int MAX_MSG_SIZE = 1024;
 	static const int MAX_USES = 8;
-	static char errorMessage[MAX_USES][MAX_MSG_SIZE];
-	static int currentStr = 0;
+	static SCUMMTR_THREAD_LOCAL char errorMessage[MAX_USES][MAX_MSG_SIZE];
+	static SCUMMTR_THREAD_LOCAL int currentStr = 0;
 	va_list va;
 
 	currentStr = (currentStr + 1) % MAX_USES;
@@ -137,6 +147,172 @@ int xmkdir(const char *path)
 	return ret;
 }
 
+// Only a hint: systems without posix_fadvise() simply read the data later,
+// when it's actually needed
+void xprefetch(const char *path, long offset, long length)
+{
+#ifdef POSIX_FADV_WILLNEED
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return;
+
+	posix_fadvise(fd, (off_t)offset, (off_t)length, POSIX_FADV_WILLNEED);
+	close(fd);
+#else
+	(void)path;
+	(void)offset;
+	(void)length;
+#endif
+}
+
+FileStamp::FileStamp() :
+    size(-1), mtime(-1), mtimeNsec(0), device(0), inode(0), racy(true)
+{
+}
+
+// A racy stamp never matches: the file may still change within the same
+// second without its stamp changing
+bool FileStamp::operator==(const FileStamp &other) const
+{
+	return !racy && !other.racy && size == other.size && mtime == other.mtime
+	    && mtimeNsec == other.mtimeNsec && device == other.device && inode == other.inode;
+}
+
+// Size, modification time and identity of a file, to tell whether it was
+// changed or replaced since it was last seen. The time is only to the second
+// on some systems, so a file modified in the second its stamp is taken gets
+// a racy stamp. Returns false if the file cannot be found.
+bool xfilestamp(const char *path, FileStamp &stamp)
+{
+	struct stat st;
+	std::time_t now;
+
+	now = std::time(nullptr);
+	if (stat(path, &st) != 0)
+	{
+		stamp = FileStamp();
+		return false;
+	}
+
+	stamp.size = (long)st.st_size;
+	stamp.mtime = (long)st.st_mtime;
+#if defined(__APPLE__)
+	stamp.mtimeNsec = (long)st.st_mtimespec.tv_nsec;
+#elif defined(st_mtime) /* st_mtim is there (glibc, musl, BSD) */
+	stamp.mtimeNsec = (long)st.st_mtim.tv_nsec;
+#else
+	stamp.mtimeNsec = 0;
+#endif
+	stamp.device = (unsigned long)st.st_dev;
+	stamp.inode = (unsigned long)st.st_ino;
+	stamp.racy = st.st_mtime >= now;
+
+	return true;
+}
+
+#if defined(_WIN32) && !defined(__DJGPP__)
+static bool xlistfilesIn(const std::string &root, const std::string &sub, std::vector<std::string> &files)
+{
+	std::string name;
+	struct _finddata_t entry;
+	intptr_t handle;
+
+	handle = _findfirst((root + sub + "*").c_str(), &entry);
+	if (handle == -1)
+		return false;
+
+	do
+	{
+		name = entry.name;
+		if (name == "." || name == "..")
+			continue;
+
+		if (entry.attrib & _A_SUBDIR)
+			xlistfilesIn(root, sub + name + '/', files);
+		else
+			files.push_back(sub + name);
+	}
+	while (_findnext(handle, &entry) == 0);
+
+	_findclose(handle);
+
+	return true;
+}
+#else
+// Directories are followed through symbolic links, so the ones being listed
+// are remembered, in case a link leads back to one of them
+static bool xlistfilesIn(const std::string &root, const std::string &sub, std::vector<std::string> &files, std::set<std::pair<dev_t, ino_t> > &parents)
+{
+	std::string name;
+	DIR *dir;
+	struct dirent *entry;
+	struct stat st;
+	std::pair<dev_t, ino_t> self;
+	bool isDir;
+
+	if (stat((root + sub).c_str(), &st) != 0)
+		return false;
+
+	self = std::make_pair(st.st_dev, st.st_ino);
+	if (!parents.insert(self).second)
+		return true;
+
+	dir = opendir((root + sub).c_str());
+	if (dir == nullptr)
+	{
+		parents.erase(self);
+		return false;
+	}
+
+	while ((entry = readdir(dir)) != nullptr)
+	{
+		name = entry->d_name;
+		if (name == "." || name == "..")
+			continue;
+
+#ifdef DT_DIR
+		// saves a stat() call on most systems (symbolic links still need one)
+		if (entry->d_type == DT_DIR || entry->d_type == DT_REG)
+			isDir = (entry->d_type == DT_DIR);
+		else
+#endif
+		isDir = stat((root + sub + name).c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+
+		if (isDir)
+			xlistfilesIn(root, sub + name + '/', files, parents);
+		else
+			files.push_back(sub + name);
+	}
+
+	closedir(dir);
+	parents.erase(self);
+
+	return true;
+}
+#endif
+
+// List all the files under a directory, with their path relative to it.
+// Returns false if the directory cannot be read.
+bool xlistfiles(const char *path, std::vector<std::string> &files)
+{
+	std::string root(path);
+
+	if (root.empty())
+		root = ".";
+	if (root[root.size() - 1] != '/')
+		root += '/';
+
+#if defined(_WIN32) && !defined(__DJGPP__)
+	return xlistfilesIn(root, "", files);
+#else
+	std::set<std::pair<dev_t, ino_t> > parents;
+
+	return xlistfilesIn(root, "", files, parents);
+#endif
+}
+
 void printCommonDisclaimer()
 {
 	std::cout << "ALWAYS MAKE BACKUPS before making changes to your games!\n\n";
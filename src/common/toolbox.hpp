@@ -28,11 +28,31 @@
 
 #include "common/types.hpp"
 
+#include <string>
+#include <vector>
+
+struct FileStamp
+{
+	long size;
+	long mtime;
+	long mtimeNsec;
+	unsigned long device;
+	unsigned long inode;
+	bool racy;
+
+	FileStamp();
+	bool operator==(const FileStamp &other) const;
+	bool operator!=(const FileStamp &other) const { return !(*this == other); }
+};
+
 const char *xsprintf(_Printf_format_string_ const char *format, ...) __attribute__((format(printf, 1, 2)));
 char *xstrdup(const char *src);
 void xremove(const char *path);
 void xrename(const char *oldname, const char *newname);
 int xmkdir(const char *path);
+void xprefetch(const char *path, long offset, long length);
+bool xfilestamp(const char *path, FileStamp &stamp);
+bool xlistfiles(const char *path, std::vector<std::string> &files);
 void printCommonDisclaimer();
 
 #endif
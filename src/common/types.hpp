@@ -97,6 +97,16 @@ typedef int int32;
 #  define _Printf_format_string_
 #endif
 
+// Per-thread storage for the few helpers returning static buffers (DJGPP and
+// some Apple toolchains don't support it, so it's left out there)
+#if defined(_MSC_VER)
+#  define SCUMMTR_THREAD_LOCAL  __declspec(thread)
+#elif (defined(__clang__) || GCC_MIN(3,3)) && !defined(__DJGPP__) && !defined(__APPLE__)
+#  define SCUMMTR_THREAD_LOCAL  __thread
+#else
+#  define SCUMMTR_THREAD_LOCAL
+#endif
+
 #define MKTAG2(a,b)     ((uint16)((b) | ((a) << 8)))
 #define MKTAG4(a,b,c,d) ((uint32)((d) | ((c) << 8) | ((b) << 16) | ((a) << 24)))
 
@@ -107,9 +117,29 @@ typedef int int32;
 #  define override
 #endif
 
-// note: assuming that your compiler optimizes this to a constant expression
+// Byte order of the target CPU, when the compiler tells it
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#  define SCUMMTR_LITTLE_ENDIAN	1
+#elif defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#  define SCUMMTR_BIG_ENDIAN	1
+#elif defined(__LITTLE_ENDIAN__) || defined(_WIN32) || defined(__DJGPP__)
+#  define SCUMMTR_LITTLE_ENDIAN	1
+#elif defined(__BIG_ENDIAN__)
+#  define SCUMMTR_BIG_ENDIAN	1
+#endif
+
+#ifdef _MSC_VER
+#  include <stdlib.h> // _byteswap_ushort(), _byteswap_ulong()
+#endif
+
 static inline bool cpu_is_little_endian()
 {
+#if defined(SCUMMTR_LITTLE_ENDIAN)
+	return true;
+#elif defined(SCUMMTR_BIG_ENDIAN)
+	return false;
+#else
+	// note: assuming that your compiler optimizes this to a constant expression
 	union
 	{
 		byte c[4];
@@ -119,6 +149,29 @@ static inline bool cpu_is_little_endian()
 	u.i = 0x12345678;
 
 	return u.c[0] == 0x78;
+#endif
+}
+
+static inline uint16 scummtr_bswap16(uint16 i)
+{
+#if defined(__clang__) || GCC_MIN(4,8)
+	return __builtin_bswap16(i);
+#elif defined(_MSC_VER)
+	return _byteswap_ushort(i);
+#else
+	return (uint16)(((i << 8) & 0xff00) | ((i >> 8) & 0x00ff));
+#endif
+}
+
+static inline uint32 scummtr_bswap32(uint32 i)
+{
+#if defined(__clang__) || GCC_MIN(4,3)
+	return __builtin_bswap32(i);
+#elif defined(_MSC_VER)
+	return _byteswap_ulong(i);
+#else
+	return ((i << 24) & 0xff000000) | ((i << 8) & 0x00ff0000) | ((i >> 8) & 0x0000ff00) | ((i >> 24) & 0x000000ff);
+#endif
 }
 
 #endif